@@ -0,0 +1,54 @@
+#include "AllocationTrap.h"
+
+#if JUCE_DEBUG
+
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace
+{
+    thread_local int noAllocationDepth = 0;
+
+    void checkAllocationAllowed() noexcept
+    {
+        if (noAllocationDepth > 0)
+        {
+            // Drop the guard while asserting, the assertion logging itself may allocate
+            const auto depth = std::exchange (noAllocationDepth, 0);
+            jassertfalse; // a real-time thread allocated or freed memory
+            noAllocationDepth = depth;
+        }
+    }
+}
+
+ScopedNoAllocation::ScopedNoAllocation() noexcept   { ++noAllocationDepth; }
+ScopedNoAllocation::~ScopedNoAllocation() noexcept  { --noAllocationDepth; }
+
+// Replacements for the global allocation functions (debug builds only). The nothrow and
+// aligned variants are left to the standard library; the nothrow ones forward here.
+void* operator new (std::size_t size)
+{
+    checkAllocationAllowed();
+
+    if (auto* p = std::malloc (size != 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)                 { return operator new (size); }
+
+void operator delete (void* p) noexcept
+{
+    if (p != nullptr)
+        checkAllocationAllowed();
+
+    std::free (p);
+}
+
+void operator delete[] (void* p) noexcept               { operator delete (p); }
+void operator delete (void* p, std::size_t) noexcept    { operator delete (p); }
+void operator delete[] (void* p, std::size_t) noexcept  { operator delete (p); }
+
+#endif
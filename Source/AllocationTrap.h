@@ -0,0 +1,18 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Debug-build guard: while one is alive on a thread, any heap allocation or free made by
+// that thread hits an assertion. Put one at the top of real-time callbacks.
+// In release builds it is an empty object and the allocator is left untouched.
+struct ScopedNoAllocation
+{
+   #if JUCE_DEBUG
+    ScopedNoAllocation() noexcept;
+    ~ScopedNoAllocation() noexcept;
+   #else
+    ScopedNoAllocation() noexcept {}
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE (ScopedNoAllocation)
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+
+// Background worker that runs the FFT pipeline away from the audio callback.
+// The audio thread never signals or waits on it: the worker polls the sample rings, drains
+// whatever is ready, and sleeps for however long the work function asks (e.g. half a hop).
+class AnalysisThread : private juce::Thread
+{
+public:
+    struct Options
+    {
+        juce::Thread::Priority priority = juce::Thread::Priority::high;
+        juce::uint32 affinityMask       = 0;     // 0 = let the OS schedule freely
+    };
+
+    // workToRun returns the number of milliseconds to sleep before the next pass.
+    explicit AnalysisThread (std::function<int()> workToRun)
+        : juce::Thread ("Spectrogram Analysis"), work (std::move (workToRun)) {}
+
+    ~AnalysisThread() override                  { stop(); }
+
+    void start()
+    {
+        stop();
+
+        if (options.affinityMask != 0)
+            setAffinityMask (options.affinityMask);   // applied when the thread starts
+
+        startThread (options.priority);
+    }
+
+    void stop()                                 { stopThread (1000); }
+
+    // Takes effect on the next start().
+    void setOptions (const Options& newOptions) { options = newOptions; }
+    const Options& getOptions() const noexcept  { return options; }
+
+    bool isRunning() const                      { return isThreadRunning(); }
+
+private:
+    std::function<int()> work;
+    Options options;
+
+    void run() override
+    {
+        while (! threadShouldExit())
+            wait (juce::jmax (1, work()));
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisThread)
+};
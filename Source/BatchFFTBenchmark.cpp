@@ -0,0 +1,102 @@
+#include <JuceHeader.h>
+
+#if JUCE_UNIT_TESTS
+
+#include "SpectrogramEngine.h"
+
+// Analysis throughput with and without batching, at host block sizes that deliver several hops
+// at once (75% overlap, as many hops per pass as the block holds, up to maxBatch). Logs the
+// time per hop of both paths for each FFT size, and checks the batched levels match the per-hop
+// ones. Timing is only reported, never asserted. Run through a juce::UnitTestRunner, category
+// "Benchmarks", in a build with JUCE_UNIT_TESTS enabled.
+class BatchFFTBenchmark : public juce::UnitTest
+{
+public:
+    BatchFFTBenchmark() : juce::UnitTest ("Batched FFT throughput", "Benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest ("Per-hop vs batched, 512 - 4096 sample blocks");
+
+        measure<9>();
+        measure<10>();
+        measure<11>();
+        measure<12>();
+    }
+
+private:
+    template <int Order>
+    void measure()
+    {
+        using Engine = SpectrogramEngine<Order>;
+        constexpr int size = Engine::fftSize;
+        constexpr int bins = Engine::numBins;
+        constexpr int hop  = size / 4;
+
+        auto engine = std::make_unique<Engine>();
+        std::vector<float> audio ((size_t) (size + Engine::maxBatch * hop));
+        std::vector<float> perHopLevels ((size_t) (Engine::maxBatch * bins));
+
+        juce::Random random (Order);
+        for (auto& x : audio)
+            x = random.nextFloat() * 2.0f - 1.0f;
+
+        for (int blockSize = 512; blockSize <= 4096; blockSize *= 2)
+        {
+            const int numHops = juce::jlimit (1, Engine::maxBatch, blockSize / hop);
+
+            auto runPerHop = [&]
+            {
+                for (int f = 0; f < numHops; ++f)
+                {
+                    std::copy_n (audio.data() + f * hop, size, engine->getInputBuffer());
+                    engine->computeDecibels (perHopLevels.data() + (size_t) f * bins, 0.0f);
+                }
+            };
+
+            auto runBatched = [&]
+            {
+                for (int f = 0; f < numHops; ++f)
+                    std::copy_n (audio.data() + f * hop, size, engine->getBatchInputBuffer (f));
+
+                engine->computeBatchDecibels (numHops, 0.0f);
+            };
+
+            // Alternate the two so clock ramps and cache warm-up don't favour whichever runs second
+            const int reps = juce::jmax (8, (1 << 19) >> Order) / numHops;
+            double perHop = std::numeric_limits<double>::max(), batched = perHop;
+
+            for (int round = 0; round < 5; ++round)
+            {
+                perHop  = juce::jmin (perHop,  FFTBackendSelection::secondsPerRun (reps, runPerHop));
+                batched = juce::jmin (batched, FFTBackendSelection::secondsPerRun (reps, runBatched));
+            }
+
+            // Bins within 30 dB of the frame's peak; quieter ones only carry the backends' rounding
+            float maxDifference = 0.0f;
+
+            for (int f = 0; f < numHops; ++f)
+            {
+                const float* expected = perHopLevels.data() + (size_t) f * bins;
+                const float* actual   = engine->getBatchDecibels (f);
+                const float  peak     = juce::FloatVectorOperations::findMaximum (expected, bins);
+
+                for (int k = 0; k < bins; ++k)
+                    if (expected[k] > peak - 30.0f)
+                        maxDifference = juce::jmax (maxDifference, std::abs (actual[k] - expected[k]));
+            }
+
+            expectLessThan (maxDifference, 0.1f, "batched levels differ from per-hop levels");
+
+            logMessage (juce::String::formatted ("FFT %5d, %4d-sample blocks (%d hops): per-hop %7.2f us/hop, batched %7.2f us/hop, x%.2f",
+                                                 size, blockSize, numHops,
+                                                 perHop  * 1.0e6 / numHops,
+                                                 batched * 1.0e6 / numHops,
+                                                 perHop / batched));
+        }
+    }
+};
+
+static BatchFFTBenchmark batchFFTBenchmark;
+
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+#include <vector>
+#include "FastDecibels.h"
+
+// Folds a fixed number of consecutive analysis hops into one screen column (analysis thread).
+// Every hop lands in exactly one column: max keeps each peak at full height, mean averages the
+// dB levels (steadier noise floor), rms averages power and converts back. A hop may arrive in
+// several parts (one per channel), each added at its offset before endHop() is called.
+class ColumnFolder
+{
+public:
+    enum class Reduction { max = 0, mean, rms };
+
+    // Allocates room for the largest column; not real-time safe.
+    void prepare (int maxValues)
+    {
+        column.assign ((size_t) maxValues, 0.0f);
+        powers.assign ((size_t) maxValues, 0.0f);
+    }
+
+    // Starts a new column if the shape or reduction changed; a new hop count only moves the end
+    // of the column being folded, which completes once it holds at least that many hops.
+    void configure (int newNumValues, int newHopsPerColumn, Reduction newReduction, float newFloorDb) noexcept
+    {
+        jassert (newNumValues <= (int) column.size());
+
+        if (newNumValues != numValues || newReduction != reduction)
+            hopIndex = 0;
+
+        numValues     = juce::jmin (newNumValues, (int) column.size());
+        hopsPerColumn = juce::jmax (1, newHopsPerColumn);
+        reduction     = newReduction;
+        floorDb       = newFloorDb;
+    }
+
+    // Folds num dB levels of the current hop into values [offset, offset + num) of the column.
+    void accumulate (int offset, const float* levels, int num) noexcept
+    {
+        jassert (offset + num <= numValues);
+        float* dest = column.data() + offset;
+        const bool first = hopIndex == 0;
+
+        switch (reduction)
+        {
+            case Reduction::mean:
+                if (first)  juce::FloatVectorOperations::copy (dest, levels, num);
+                else        juce::FloatVectorOperations::add (dest, levels, num);
+                break;
+
+            case Reduction::rms:
+                if (first)
+                {
+                    FastDecibels::toPower (levels, dest, num);
+                }
+                else
+                {
+                    FastDecibels::toPower (levels, powers.data(), num);
+                    juce::FloatVectorOperations::add (dest, powers.data(), num);
+                }
+                break;
+
+            case Reduction::max:
+            default:
+                if (first)  juce::FloatVectorOperations::copy (dest, levels, num);
+                else        juce::FloatVectorOperations::max (dest, dest, levels, num);
+                break;
+        }
+    }
+
+    // Ends the current hop. Returns true when it completed a column, which getColumn() then
+    // holds in dB until the next accumulate().
+    bool endHop() noexcept
+    {
+        if (++hopIndex < hopsPerColumn)
+            return false;
+
+        // Divide by the hops actually folded, which exceed hopsPerColumn if it shrank mid-column
+        if (reduction == Reduction::mean)
+            juce::FloatVectorOperations::multiply (column.data(), 1.0f / (float) hopIndex, numValues);
+        else if (reduction == Reduction::rms)
+            FastDecibels::fromPower (column.data(), column.data(), numValues,
+                                     -10.0f * std::log10 ((float) hopIndex), floorDb);
+
+        hopIndex = 0;
+        return true;
+    }
+
+    const float* getColumn() const noexcept  { return column.data(); }
+
+private:
+    std::vector<float> column;      // running max / sum of dB / sum of power
+    std::vector<float> powers;      // one hop's levels as power, for rms
+    int numValues = 0, hopsPerColumn = 1, hopIndex = 0;
+    Reduction reduction = Reduction::max;
+    float floorDb = -160.0f;
+};
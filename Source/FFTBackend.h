@@ -0,0 +1,143 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+#include "LaneRealFFT.h"
+
+#if TELEVISION_USE_FFTW
+ #include <fftw3.h>     // define TELEVISION_USE_FFTW=1 and link against fftw3f to enable
+#endif
+
+// Interchangeable real-FFT implementations for the single-frame analysis path.
+// All of them produce the power spectrum |X[k]|^2 (no square root; levels are taken from power)
+// and agree to within FFTBackendSelection::maxRelativeError of the frame's peak, so the choice
+// between them is purely a matter of speed on the machine at hand.
+enum class FFTBackendType
+{
+    juce = 0,       // juce::dsp::FFT: IPP / vDSP / FFTW when JUCE is built with them, else its fallback
+    laneRadix2,     // in-tree LaneRealFFT, one lane
+    fftw            // FFTW r2c plan, when compiled in
+};
+
+class FFTBackend
+{
+public:
+    virtual ~FFTBackend() = default;
+
+    // data holds fftSize windowed samples and has room for 2 * fftSize floats; it may be
+    // overwritten. Writes fftSize / 2 powers to powerOut.
+    virtual void performPower (float* data, float* powerOut) noexcept = 0;
+};
+
+//==============================================================================
+namespace FFTBackendDetail
+{
+    class JuceBackend final : public FFTBackend
+    {
+    public:
+        explicit JuceBackend (int order) : fft (order) {}
+
+        void performPower (float* data, float* powerOut) noexcept override
+        {
+            const int n = fft.getSize();
+            std::fill (data + n, data + 2 * n, 0.0f);
+            fft.performRealOnlyForwardTransform (data, true);   // interleaved re / im
+
+            for (int k = 0; k < n / 2; ++k)
+                powerOut[k] = data[2 * k] * data[2 * k] + data[2 * k + 1] * data[2 * k + 1];
+        }
+
+    private:
+        juce::dsp::FFT fft;
+    };
+
+    template <int Order>
+    class LaneBackend final : public FFTBackend
+    {
+    public:
+        void performPower (float* data, float* powerOut) noexcept override
+        {
+            fft.performPower (&data, 1, nullptr, &powerOut);
+        }
+
+    private:
+        LaneRealFFT<Order, 1> fft;
+    };
+
+   #if TELEVISION_USE_FFTW
+    class FFTWBackend final : public FFTBackend
+    {
+    public:
+        explicit FFTWBackend (int order)
+            : size (1 << order),
+              in (fftwf_alloc_real ((size_t) size)),
+              out (fftwf_alloc_complex ((size_t) size / 2 + 1))
+        {
+            // Planning isn't thread-safe in FFTW; engines may be built on several threads
+            const juce::SpinLock::ScopedLockType sl (getPlannerLock());
+            plan = fftwf_plan_dft_r2c_1d (size, in, out, FFTW_MEASURE);
+        }
+
+        ~FFTWBackend() override
+        {
+            {
+                const juce::SpinLock::ScopedLockType sl (getPlannerLock());
+                fftwf_destroy_plan (plan);
+            }
+
+            fftwf_free (in);
+            fftwf_free (out);
+        }
+
+        void performPower (float* data, float* powerOut) noexcept override
+        {
+            std::copy (data, data + size, in);
+            fftwf_execute (plan);
+
+            for (int k = 0; k < size / 2; ++k)
+                powerOut[k] = out[k][0] * out[k][0] + out[k][1] * out[k][1];
+        }
+
+    private:
+        const int size;
+        float* in;
+        fftwf_complex* out;
+        fftwf_plan plan;
+
+        static juce::SpinLock& getPlannerLock()
+        {
+            static juce::SpinLock lock;
+            return lock;
+        }
+    };
+   #endif
+}
+
+inline bool isFFTBackendAvailable (FFTBackendType type) noexcept
+{
+   #if TELEVISION_USE_FFTW
+    juce::ignoreUnused (type);
+    return true;
+   #else
+    return type != FFTBackendType::fftw;
+   #endif
+}
+
+// Not real-time safe: allocates and plans. Falls back to JUCE for a backend that isn't compiled in.
+template <int Order>
+std::unique_ptr<FFTBackend> createFFTBackend (FFTBackendType type)
+{
+    switch (type)
+    {
+        case FFTBackendType::laneRadix2:
+            return std::make_unique<FFTBackendDetail::LaneBackend<Order>>();
+
+       #if TELEVISION_USE_FFTW
+        case FFTBackendType::fftw:
+            return std::make_unique<FFTBackendDetail::FFTWBackend> (Order);
+       #endif
+
+        default:
+            return std::make_unique<FFTBackendDetail::JuceBackend> (Order);
+    }
+}
@@ -0,0 +1,99 @@
+#include "FFTBackendSelection.h"
+
+FFTBackendSelection& FFTBackendSelection::getInstance()
+{
+    static FFTBackendSelection instance;
+    return instance;
+}
+
+juce::File FFTBackendSelection::getCacheFile()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+             .getChildFile ("Television")
+             .getChildFile ("FFTBackends.xml");
+}
+
+// A different CPU, JUCE version or set of compiled-in backends invalidates the measurements
+juce::String FFTBackendSelection::getBuildKey()
+{
+    return juce::String (JucePlugin_VersionString) + " " + juce::SystemStats::getJUCEVersion()
+             + (isFFTBackendAvailable (FFTBackendType::fftw) ? " fftw" : "");
+}
+
+void FFTBackendSelection::loadIfNeeded()
+{
+    if (std::exchange (loaded, true))
+        return;
+
+    auto xml = juce::XmlDocument::parse (getCacheFile());
+
+    if (xml == nullptr || ! xml->hasTagName ("FFTBACKENDS")
+         || xml->getStringAttribute ("cpu")   != juce::SystemStats::getCpuModel()
+         || xml->getStringAttribute ("build") != getBuildKey())
+        return;
+
+    for (auto* e : xml->getChildWithTagNameIterator ("ORDER"))
+    {
+        Choice c;
+        c.backend        = (FFTBackendType) e->getIntAttribute ("backend");
+        c.useLaneBatches = e->getBoolAttribute ("laneBatches");
+
+        if (isFFTBackendAvailable (c.backend))
+            choices[e->getIntAttribute ("order")] = c;
+    }
+}
+
+void FFTBackendSelection::save() const
+{
+    juce::XmlElement xml ("FFTBACKENDS");
+    xml.setAttribute ("cpu",   juce::SystemStats::getCpuModel());
+    xml.setAttribute ("build", getBuildKey());
+
+    for (auto& [order, c] : choices)
+    {
+        auto* e = xml.createNewChildElement ("ORDER");
+        e->setAttribute ("order",       order);
+        e->setAttribute ("backend",     (int) c.backend);
+        e->setAttribute ("laneBatches", c.useLaneBatches);
+    }
+
+    // Failing to write only means measuring again next time
+    const auto file = getCacheFile();
+    file.getParentDirectory().createDirectory();
+    xml.writeTo (file);
+}
+
+// Best of three timed batches, after one warm-up run
+double FFTBackendSelection::secondsPerRun (int reps, const std::function<void()>& run)
+{
+    run();
+    auto best = std::numeric_limits<juce::int64>::max();
+
+    for (int trial = 0; trial < 3; ++trial)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < reps; ++i)
+            run();
+
+        best = juce::jmin (best, juce::Time::getHighResolutionTicks() - start);
+    }
+
+    return juce::Time::highResolutionTicksToSeconds (best) / reps;
+}
+
+bool FFTBackendSelection::matchesReference (const std::vector<float>& reference, const float* result)
+{
+    float peak = 0.0f, maxError = 0.0f;
+
+    for (size_t k = 0; k < reference.size(); ++k)
+    {
+        peak     = juce::jmax (peak, reference[k]);
+        maxError = juce::jmax (maxError, std::abs (reference[k] - result[k]));
+    }
+
+    // A backend outside tolerance is a bug in it, not a reason to stop the plugin
+    const bool ok = maxError <= maxRelativeError * peak;
+    jassert (ok);
+    return ok;
+}
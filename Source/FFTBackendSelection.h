@@ -0,0 +1,137 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <limits>
+#include <map>
+#include <vector>
+#include "FFTBackend.h"
+
+// Picks the fastest FFT backend for each order by timing every available one once, and caches
+// the result on disk (keyed by CPU and build) so later plugin loads skip the measurement.
+// Shared by all plugin instances in the process; orders are measured lazily, the first time an
+// engine of that size is built.
+class FFTBackendSelection
+{
+public:
+    struct Choice
+    {
+        FFTBackendType backend = FFTBackendType::juce;
+        bool useLaneBatches = false;    // LaneRealFFT across several frames beats one at a time
+    };
+
+    // Every candidate's power spectrum must match the JUCE reference to this fraction of the
+    // frame's peak power (errors ~1e-5 of the peak magnitude, -100 dB, well below the display's
+    // 80 dB range) or it is never chosen.
+    static constexpr float maxRelativeError = 2.0e-5f;
+
+    static constexpr int benchmarkLanes = 4;
+
+    static FFTBackendSelection& getInstance();
+
+    // Best of three timed batches of reps runs, after one warm-up run; seconds per run.
+    static double secondsPerRun (int reps, const std::function<void()>& run);
+
+    // Not real-time safe: may run the benchmark (up to a few tens of ms) and write the cache file.
+    template <int Order>
+    Choice getChoice()
+    {
+        const juce::ScopedLock sl (lock);
+        loadIfNeeded();
+
+        auto found = choices.find (Order);
+        if (found != choices.end())
+            return found->second;
+
+        const auto choice = measure<Order>();
+        choices[Order] = choice;
+        save();
+        return choice;
+    }
+
+private:
+    FFTBackendSelection() = default;
+
+    juce::CriticalSection lock;
+    std::map<int, Choice> choices;
+    bool loaded = false;
+
+    static juce::File getCacheFile();
+    static juce::String getBuildKey();
+    void loadIfNeeded();
+    void save() const;
+
+    static bool matchesReference (const std::vector<float>& reference, const float* result);
+
+    template <int Order>
+    static Choice measure()
+    {
+        constexpr int size    = 1 << Order;
+        constexpr int numBins = size / 2;
+        const int reps = juce::jmax (4, (1 << 17) >> Order);
+
+        std::vector<float> input ((size_t) size), data ((size_t) size * 2);
+        std::vector<float> reference ((size_t) numBins), result ((size_t) numBins);
+
+        juce::Random random (Order);
+        for (auto& x : input)
+            x = random.nextFloat() * 2.0f - 1.0f;
+
+        auto run = [&] (FFTBackend& backend, float* out)
+        {
+            std::copy (input.begin(), input.end(), data.begin());
+            backend.performPower (data.data(), out);
+        };
+
+        Choice best;
+        double bestTime = std::numeric_limits<double>::max();
+
+        // JUCE goes first: it is the reference the others are checked against
+        for (auto type : { FFTBackendType::juce, FFTBackendType::laneRadix2, FFTBackendType::fftw })
+        {
+            if (! isFFTBackendAvailable (type))
+                continue;
+
+            auto backend = createFFTBackend<Order> (type);
+            run (*backend, result.data());
+
+            if (type == FFTBackendType::juce)
+                reference = result;
+            else if (! matchesReference (reference, result.data()))
+                continue;
+
+            const double t = secondsPerRun (reps, [&] { run (*backend, result.data()); });
+
+            if (t < bestTime)
+            {
+                bestTime = t;
+                best.backend = type;
+            }
+        }
+
+        // Frames side by side in SIMD lanes, timed per frame
+        LaneRealFFT<Order, benchmarkLanes> laneFFT;
+        std::vector<float> laneOut ((size_t) (benchmarkLanes * numBins));
+        const float* frames[benchmarkLanes];
+        float* outs[benchmarkLanes];
+
+        for (int l = 0; l < benchmarkLanes; ++l)
+        {
+            frames[l] = input.data();
+            outs[l]   = laneOut.data() + l * numBins;
+        }
+
+        auto runLanes = [&] { laneFFT.performPower (frames, benchmarkLanes, nullptr, outs); };
+        runLanes();
+
+        if (matchesReference (reference, outs[benchmarkLanes - 1]))
+        {
+            const int laneReps = (reps + benchmarkLanes - 1) / benchmarkLanes;
+            best.useLaneBatches = secondsPerRun (laneReps, runLanes) / benchmarkLanes < bestTime;
+        }
+
+        return best;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (FFTBackendSelection)
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstdint>
+#include <cstring>
+
+// Branch-free level conversion for whole spectra.
+// log2 is split into the float's exponent plus a degree-5 polynomial in the mantissa (error
+// under 1e-4 dB), so each element is a handful of integer and multiply-add ops and the loops vectorise.
+// Zero and denormal inputs land far below any useful floor and are clamped by a max, not a branch.
+namespace FastDecibels
+{
+    inline float log2Approx (float x) noexcept
+    {
+        uint32_t bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+
+        const float exponent = (float) ((int32_t) ((bits >> 23) & 0xffu) - 127);
+        bits = (bits & 0x007fffffu) | 0x3f800000u;      // mantissa as a float in [1, 2)
+
+        float m;
+        std::memcpy (&m, &bits, sizeof (m));
+        const float t = m - 1.0f;
+
+        return exponent + t * (1.44196547f + t * (-0.709661358f + t * (0.417591329f
+                                           + t * (-0.19626428f + t * 0.0463831382f))));
+    }
+
+    // out[i] = max (dbPerOctave * log2 (in[i]) + offsetDb, floorDb). in and out may be the same.
+    inline void convert (const float* in, float* out, int num,
+                         float dbPerOctave, float offsetDb, float floorDb) noexcept
+    {
+        for (int i = 0; i < num; ++i)
+            out[i] = juce::jmax (dbPerOctave * log2Approx (in[i]) + offsetDb, floorDb);
+    }
+
+    // 10 log10 (power) + offsetDb: levels straight from |X|^2, no square root.
+    inline void fromPower (const float* power, float* out, int num, float offsetDb, float floorDb) noexcept
+    {
+        convert (power, out, num, 3.01029996f, offsetDb, floorDb);
+    }
+
+    // 20 log10 (magnitude) + offsetDb.
+    inline void fromMagnitude (const float* magnitude, float* out, int num, float offsetDb, float floorDb) noexcept
+    {
+        convert (magnitude, out, num, 6.02059991f, offsetDb, floorDb);
+    }
+
+    // 2^x for x in [-126, 126], relative error ~1e-7: integer part into the exponent bits, a
+    // degree-5 polynomial for the fraction. Out-of-range inputs are clamped.
+    inline float exp2Approx (float x) noexcept
+    {
+        x = juce::jlimit (-126.0f, 126.0f, x);
+
+        const int32_t whole = (int32_t) (x + 127.0f) - 127;     // floor, as x + 127 > 0
+        const float   f     = x - (float) whole;
+
+        const float m = 0.99999990f + f * (0.693154490f + f * (0.240141818f + f * (0.0558603371f
+                                         + f * (0.00894959042f + f * 0.00189375406f))));
+
+        uint32_t bits;
+        std::memcpy (&bits, &m, sizeof (bits));
+        bits += (uint32_t) whole << 23;
+
+        float result;
+        std::memcpy (&result, &bits, sizeof (result));
+        return result;
+    }
+
+    // 10^(db / 10), for averaging levels in the power domain.
+    inline float toPower (float db) noexcept
+    {
+        return exp2Approx (db * 0.332192809f);
+    }
+
+    // out[i] = 10^(db[i] / 10) for a whole spectrum. db and out may be the same.
+    inline void toPower (const float* db, float* out, int num) noexcept
+    {
+        for (int i = 0; i < num; ++i)
+            out[i] = toPower (db[i]);
+    }
+}
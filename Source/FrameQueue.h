@@ -0,0 +1,143 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+// Bounded single-producer / single-consumer queue of analysis frames.
+// A frame is numChannels consecutive spectra of numBins values each, stored as floats or as
+// 16- / 8-bit codes, so frames of different FFT sizes, channel counts and formats can be in
+// flight together (e.g. while the user changes them). Payloads live contiguously in a byte
+// arena, 16-byte aligned (a frame that would straddle the end starts again at the beginning);
+// headers live in a separate ring that carries sequence number, shape and format.
+// Every frame the producer offers gets the next sequence number, whether or not it fits;
+// when the queue is full the frame is dropped and counted, so the reader can see gaps.
+class FrameQueue
+{
+public:
+    enum class Format : uint8_t { float32 = 0, uint16, uint8 };
+
+    static constexpr int getBytesPerValue (Format f) noexcept
+    {
+        return f == Format::uint8 ? 1 : (f == Format::uint16 ? 2 : 4);
+    }
+
+    struct FrameInfo
+    {
+        uint64_t sequence = 0;
+        int numBins = 0, numChannels = 0;
+        int layout = 0;             // producer-defined tag describing what the channels are
+        Format format = Format::float32;
+        uint64_t position = 0;      // producer-defined: where in its stream the frame ends
+    };
+
+    FrameQueue() = default;
+
+    // Not real-time safe: allocates. Call before either side starts using the queue.
+    // arenaBytes must hold at least one of the largest frames that will be written.
+    void prepare (int arenaBytes, int maxNumFrames)
+    {
+        arenaSize  = juce::nextPowerOfTwo (juce::jmax (arenaBytes, (int) alignment));
+        arenaMask  = (uint64_t) arenaSize - 1;
+        numHeaders = juce::nextPowerOfTwo (juce::jmax (maxNumFrames, 2));
+        headerMask = (uint64_t) numHeaders - 1;
+
+        arena.assign ((size_t) arenaSize, 0);
+        headers.assign ((size_t) numHeaders, {});
+
+        writePos.store (0, std::memory_order_relaxed);
+        readPos.store  (0, std::memory_order_relaxed);
+        arenaWrite = 0;
+        nextSequence = 0;
+        numDropped.store (0, std::memory_order_relaxed);
+    }
+
+
+    // ===== Producer =====
+    // Returns space for numChannels * numBins values of the given format, or nullptr if the
+    // reader is too far behind (the frame is then dropped).
+    void* beginWrite (int numBins, int numChannels, int layout = 0, Format format = Format::float32,
+                      uint64_t position = 0) noexcept
+    {
+        const auto w = writePos.load (std::memory_order_relaxed);
+        const auto r = readPos.load (std::memory_order_acquire);
+        const auto size = getPayloadSize (numBins, numChannels, format);
+
+        // Frames never straddle the end of the arena: pad to the start if needed
+        const auto offset = arenaWrite & arenaMask;
+        const auto pad    = offset + size > (uint64_t) arenaSize ? (uint64_t) arenaSize - offset : 0;
+        const auto oldest = (w != r) ? headers[(size_t) (r & headerMask)].start : arenaWrite;
+
+        if (w - r >= (uint64_t) numHeaders
+             || (arenaWrite - oldest) + pad + size > (uint64_t) arenaSize)
+        {
+            ++nextSequence;
+            numDropped.fetch_add (1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        auto& h = headers[(size_t) (w & headerMask)];
+        h.start = arenaWrite + pad;
+        h.info  = { nextSequence, numBins, numChannels, layout, format, position };
+
+        return arena.data() + (size_t) (h.start & arenaMask);
+    }
+
+    void finishWrite() noexcept
+    {
+        const auto w = writePos.load (std::memory_order_relaxed);
+        const auto& h = headers[(size_t) (w & headerMask)];
+
+        arenaWrite = h.start + getPayloadSize (h.info.numBins, h.info.numChannels, h.info.format);
+        ++nextSequence;
+        writePos.store (w + 1, std::memory_order_release);
+    }
+
+    // ===== Consumer =====
+    int getNumReady() const noexcept
+    {
+        return (int) (writePos.load (std::memory_order_acquire) - readPos.load (std::memory_order_relaxed));
+    }
+
+    // Oldest unread frame; only valid while getNumReady() > 0. Cast according to info.format.
+    const void* front (FrameInfo& info) const noexcept
+    {
+        const auto& h = headers[(size_t) (readPos.load (std::memory_order_relaxed) & headerMask)];
+        info = h.info;
+        return arena.data() + (size_t) (h.start & arenaMask);
+    }
+
+    void pop() noexcept
+    {
+        readPos.store (readPos.load (std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    uint64_t getNumDropped() const noexcept { return numDropped.load (std::memory_order_relaxed); }
+
+private:
+    struct Header
+    {
+        uint64_t start = 0;         // absolute arena position of the payload
+        FrameInfo info;
+    };
+
+    static uint64_t getPayloadSize (int numBins, int numChannels, Format format) noexcept
+    {
+        const auto bytes = (uint64_t) numBins * (uint64_t) numChannels * (uint64_t) getBytesPerValue (format);
+        return (bytes + alignment - 1) & ~(alignment - 1);
+    }
+
+    static constexpr uint64_t alignment = 16;
+
+    std::vector<uint8_t> arena;
+    std::vector<Header>  headers;
+    int      arenaSize = 0, numHeaders = 0;
+    uint64_t arenaMask = 0, headerMask = 0;
+
+    alignas (64) std::atomic<uint64_t> writePos { 0 };
+    uint64_t arenaWrite = 0, nextSequence = 0;       // producer-owned
+    alignas (64) std::atomic<uint64_t> readPos  { 0 };
+    alignas (64) std::atomic<uint64_t> numDropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (FrameQueue)
+};
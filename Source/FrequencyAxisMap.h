@@ -0,0 +1,118 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+#include <vector>
+
+// Bin -> screen row table for one spectrogram lane, rebuilt only when the lane height, FFT size,
+// sample rate or axis change. Row 0 is the bottom (lowest) row. Rows narrower than a bin
+// interpolate between the two nearest bins; rows spanning several bins take their maximum, so a
+// narrow peak never falls between rows. Levels are in dB and stay in dB.
+class FrequencyAxisMap
+{
+public:
+    enum class Axis { linear = 0, logarithmic, mel };
+
+    static constexpr double minLogHz = 20.0;     // bottom of the log axis; linear and mel start at 0
+
+    bool matches (Axis otherAxis, int otherNumBins, double otherSampleRate, int otherNumRows) const noexcept
+    {
+        return otherAxis == axis && otherNumBins == numBins && otherSampleRate == sampleRate
+                 && otherNumRows == (int) rows.size();
+    }
+
+    // Returns true if the table was rebuilt.
+    bool update (Axis newAxis, int newNumBins, double newSampleRate, int newNumRows)
+    {
+        if (matches (newAxis, newNumBins, newSampleRate, newNumRows))
+            return false;
+
+        axis = newAxis;
+        numBins = juce::jmax (2, newNumBins);
+        sampleRate = newSampleRate;
+        rows.resize ((size_t) juce::jmax (0, newNumRows));
+
+        const double nyquist = sampleRate * 0.5;
+        const double numRows = (double) rows.size();
+
+        // Bin k sits at k * nyquist / numBins Hz
+        auto binAt = [&] (double proportion)
+        {
+            return juce::jlimit (0.0, (double) (numBins - 1), frequencyAt (proportion, nyquist) / nyquist * numBins);
+        };
+
+        for (size_t r = 0; r < rows.size(); ++r)
+        {
+            const double low  = binAt ((double) r / numRows);
+            const double high = binAt ((double) (r + 1) / numRows);
+            auto& row = rows[r];
+
+            if (high - low >= 1.0)
+            {
+                row.first = (int) std::ceil (low);
+                row.last  = juce::jmax (row.first, (int) std::floor (high));
+                row.frac  = 0.0f;
+            }
+            else
+            {
+                const double centre = binAt (((double) r + 0.5) / numRows);
+                row.first = juce::jmin ((int) centre, numBins - 2);
+                row.last  = row.first;
+                row.frac  = (float) (centre - row.first);
+            }
+        }
+
+        return true;
+    }
+
+    int getNumRows() const noexcept    { return (int) rows.size(); }
+
+    // levels: numBins dB values; rowLevels: getNumRows() dB values, bottom row first
+    void apply (const float* levels, float* rowLevels) const noexcept
+    {
+        for (size_t r = 0; r < rows.size(); ++r)
+        {
+            const auto& row = rows[r];
+
+            if (row.last > row.first)
+                rowLevels[r] = juce::FloatVectorOperations::findMaximum (levels + row.first, row.last - row.first + 1);
+            else
+                rowLevels[r] = levels[row.first] + row.frac * (levels[row.first + 1] - levels[row.first]);
+        }
+    }
+
+private:
+    struct Row
+    {
+        int first = 0, last = 0;    // bins to max-pool, or first == last: interpolate first..first + 1
+        float frac = 0.0f;
+    };
+
+    Axis axis = Axis::linear;
+    int numBins = 0;
+    double sampleRate = 0.0;
+    std::vector<Row> rows;
+
+    // Frequency at a proportion of the lane height, 0 at the bottom edge and 1 at the top
+    double frequencyAt (double proportion, double nyquist) const noexcept
+    {
+        switch (axis)
+        {
+            case Axis::logarithmic:
+            {
+                const double bottom = juce::jmin (minLogHz, nyquist * 0.5);
+                return bottom * std::pow (nyquist / bottom, proportion);
+            }
+
+            case Axis::mel:
+            {
+                auto toMel = [] (double hz) { return 2595.0 * std::log10 (1.0 + hz / 700.0); };
+                return 700.0 * (std::pow (10.0, proportion * toMel (nyquist) / 2595.0) - 1.0);
+            }
+
+            case Axis::linear:
+            default:
+                return proportion * nyquist;
+        }
+    }
+};
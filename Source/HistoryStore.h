@@ -0,0 +1,225 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Long spectrogram history as a time pyramid of 8-bit level codes, within a fixed memory cap.
+// Level 0 holds every column appended; each level above holds one column per two of the level
+// below (max or mean of the pair), so level k spans 2^k times as long in the same memory.
+// Each level is a ring of tiles allocated on first use, so a short history stays small.
+// One writer (the analysis thread) appends; readers on any thread fold a range of columns
+// from the coarsest level that resolves it, so a read costs O(values returned) at any zoom.
+// Readers share a read/write lock and run concurrently. The writer folds each new column up
+// the pyramid outside it and only holds it exclusively to copy the results into place.
+class HistoryStore
+{
+public:
+    enum class Reduction { max = 0, mean };
+
+    static constexpr int numLevels = 12;                    // up to 2048 columns folded into one
+    static constexpr size_t tileBytes = 256 * 1024;
+
+    struct Shape
+    {
+        int numBins = 0, numChannels = 0, layout = 0;
+        int hopSize = 0;            // samples between level-0 columns
+
+        int getNumValues() const noexcept   { return numBins * numChannels; }
+
+        bool operator== (const Shape& other) const noexcept
+        {
+            return numBins == other.numBins && numChannels == other.numChannels && layout == other.layout
+                && hopSize == other.hopSize;
+        }
+
+        bool operator!= (const Shape& other) const noexcept   { return ! operator== (other); }
+    };
+
+    explicit HistoryStore (size_t memoryLimitBytes, Reduction pyramidReduction = Reduction::max)
+        : memoryLimit (memoryLimitBytes), reduction (pyramidReduction) {}
+
+    // Any thread. The history restarts under the new cap with the next appended column. Each
+    // level gets an equal share, in tiles of up to tileBytes; a level never holds less than one
+    // column, so the cap is raised to numLevels columns of the current shape if it is smaller.
+    void setMemoryLimit (size_t bytes) noexcept
+    {
+        memoryLimit.store (bytes);
+        restartRequested.store (true);
+    }
+
+    size_t getMemoryLimit() const noexcept   { return memoryLimit.load(); }
+
+    // Writer thread only. A column of a different shape (FFT size, overlap or channel view
+    // changed) starts a new history. May allocate a tile per level, never while holding the lock.
+    void append (const uint8_t* codes, const Shape& columnShape)
+    {
+        if (restartRequested.exchange (false) || columnShape != shape)
+            restart (columnShape);
+
+        // Level 0 takes the column; every pair it completes adds a column one level up. Only this
+        // thread writes the slots, so the folds read them unlocked into foldScratch.
+        ensureTile (0, numWritten);
+        int numFolds = 0;
+
+        for (const uint8_t* newer = codes; numFolds + 1 < numLevels && ((numWritten >> numFolds) & 1) != 0; ++numFolds)
+        {
+            const uint64_t j = numWritten >> numFolds;
+            ensureTile (numFolds + 1, j >> 1);
+
+            uint8_t* folded = foldScratch.data() + (size_t) numFolds * (size_t) valuesPerColumn;
+            fold (folded, slot (numFolds, j - 1), newer);
+            newer = folded;
+        }
+
+        const juce::ScopedWriteLock sl (lock);
+
+        std::memcpy (slot (0, numWritten), codes, (size_t) valuesPerColumn);
+
+        for (int k = 0; k < numFolds; ++k)
+            std::memcpy (slot (k + 1, numWritten >> (k + 1)),
+                         foldScratch.data() + (size_t) k * (size_t) valuesPerColumn, (size_t) valuesPerColumn);
+
+        ++numWritten;
+        ++numAppendedTotal;
+    }
+
+    // Number of level-0 columns since the history (re)started, and their shape. Any thread.
+    uint64_t getNumColumns (Shape& columnShape) const
+    {
+        uint64_t numAppended;
+        return getNumColumns (columnShape, numAppended);
+    }
+
+    // As above, plus the number of columns appended since the store was created, counting
+    // across restarts, taken at the same moment.
+    uint64_t getNumColumns (Shape& columnShape, uint64_t& numAppended) const
+    {
+        const juce::ScopedReadLock sl (lock);
+        columnShape = shape;
+        numAppended = numAppendedTotal;
+        return numWritten;
+    }
+
+    // Writer thread only, no lock needed: the running count getNumColumns() reports
+    uint64_t getNumAppended() const noexcept    { return numAppendedTotal; }
+
+    // Any thread. Folds level-0 columns [first, last) into dest, the same way as the pyramid,
+    // from the fewest pyramid columns that tile exactly that range: O(numLevels) of them, plus one
+    // per top-level column it spans, so a range aligned to its power-of-two length is a single
+    // read. Columns that have left a finer level's ring come from the coarser column holding
+    // them, which may reach outside the range. Returns false, leaving dest alone, if the shape is
+    // no longer expectedShape or nothing in the range is retained.
+    bool read (uint64_t first, uint64_t last, uint8_t* dest, const Shape& expectedShape) const
+    {
+        const juce::ScopedReadLock sl (lock);
+
+        if (expectedShape != shape || first >= last || first >= numWritten)
+            return false;
+
+        last = std::min (last, numWritten);
+        bool found = false;
+
+        for (uint64_t pos = first; pos < last;)
+        {
+            // The largest aligned block starting at pos that ends by last
+            int k = 0;
+            while (k + 1 < numLevels && (pos & ((2ull << k) - 1)) == 0 && pos + (2ull << k) <= last)
+                ++k;
+
+            while (k + 1 < numLevels && (numWritten >> k) - (pos >> k) > columnsPerLevel)
+                ++k;
+
+            const uint64_t j = pos >> k;
+            pos = std::min (last, (j + 1) << k);
+
+            if (j >= (numWritten >> k) || (numWritten >> k) - j > columnsPerLevel)
+                continue;       // not retained at any level
+
+            if (found)
+                fold (dest, dest, slot (k, j));
+            else
+                std::memcpy (dest, slot (k, j), (size_t) valuesPerColumn);
+
+            found = true;
+        }
+
+        return found;
+    }
+
+private:
+    mutable juce::ReadWriteLock lock;
+    std::atomic<size_t> memoryLimit;
+    std::atomic<bool> restartRequested { false };
+    const Reduction reduction;
+
+    // Written by the writer thread under the lock; readable without it on that thread
+    Shape shape;
+    int valuesPerColumn = 0;
+    int columnsPerTile = 1, tilesPerLevel = 1;
+    uint64_t columnsPerLevel = 1;
+    uint64_t numWritten = 0;
+    uint64_t numAppendedTotal = 0;                          // never reset
+    std::vector<std::unique_ptr<uint8_t[]>> tiles;          // [level][tile], null until first used
+    std::vector<uint8_t> foldScratch;                       // [level - 1][value], writer only
+
+    void restart (const Shape& newShape)
+    {
+        const int values = juce::jmax (1, newShape.getNumValues());
+        const size_t perLevelBytes = memoryLimit.load() / (size_t) numLevels;
+
+        // Small caps shrink the tiles rather than round up to a whole tileBytes per level
+        const size_t levelColumns = juce::jmax ((size_t) 1, perLevelBytes / (size_t) values);
+        const int perTile  = (int) juce::jmin (levelColumns, juce::jmax ((size_t) 1, tileBytes / (size_t) values));
+        const int numTiles = (int) (levelColumns / (size_t) perTile);
+
+        std::vector<std::unique_ptr<uint8_t[]>> newTiles ((size_t) (numLevels * numTiles));
+        foldScratch.resize ((size_t) (numLevels - 1) * (size_t) values);
+
+        {
+            const juce::ScopedWriteLock sl (lock);
+            shape = newShape;
+            valuesPerColumn = values;
+            columnsPerTile  = perTile;
+            tilesPerLevel   = numTiles;
+            columnsPerLevel = (uint64_t) perTile * (uint64_t) numTiles;
+            numWritten = 0;
+            std::swap (tiles, newTiles);
+        }
+    }   // the old tiles are freed here, outside the lock
+
+    void ensureTile (int level, uint64_t j)
+    {
+        auto& tile = tiles[(size_t) (level * tilesPerLevel) + (size_t) ((j % columnsPerLevel) / (uint64_t) columnsPerTile)];
+
+        if (tile == nullptr)
+        {
+            std::unique_ptr<uint8_t[]> newTile (new uint8_t[(size_t) columnsPerTile * (size_t) valuesPerColumn]);
+            const juce::ScopedWriteLock sl (lock);
+            std::swap (tile, newTile);
+        }
+    }
+
+    uint8_t* slot (int level, uint64_t j) const noexcept
+    {
+        const uint64_t s = j % columnsPerLevel;
+        return tiles[(size_t) (level * tilesPerLevel) + (size_t) (s / (uint64_t) columnsPerTile)].get()
+                 + (size_t) (s % (uint64_t) columnsPerTile) * (size_t) valuesPerColumn;
+    }
+
+    void fold (uint8_t* dest, const uint8_t* a, const uint8_t* b) const noexcept
+    {
+        if (reduction == Reduction::mean)
+            for (int i = 0; i < valuesPerColumn; ++i)
+                dest[i] = (uint8_t) ((a[i] + b[i] + 1) >> 1);
+        else
+            for (int i = 0; i < valuesPerColumn; ++i)
+                dest[i] = std::max (a[i], b[i]);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (HistoryStore)
+};
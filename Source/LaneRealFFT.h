@@ -0,0 +1,142 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+#include <vector>
+
+// In-tree real FFT (power spectrum only) for a fixed order, transforming up to Lanes frames at once.
+// Each real frame becomes one half-length complex FFT (even samples real, odd samples imaginary),
+// radix-2 decimation in time, untangled afterwards. Samples of the frames are interleaved so the
+// innermost loops run across lanes: with Lanes = 4 every butterfly is one SIMD op over four frames,
+// with Lanes = 1 it is a plain portable single-frame FFT. Tables are built in double precision.
+template <int Order, int Lanes>
+class LaneRealFFT
+{
+public:
+    static constexpr int fftSize = 1 << Order;
+    static constexpr int numBins = fftSize / 2;
+    static constexpr int lanes   = Lanes;
+
+    LaneRealFFT()
+        : laneRe ((size_t) (half * Lanes)), laneIm ((size_t) (half * Lanes)),
+          twiddleRe ((size_t) half / 2), twiddleIm ((size_t) half / 2),
+          splitRe ((size_t) half), splitIm ((size_t) half), bitReversed ((size_t) half)
+    {
+        for (int i = 0; i < half; ++i)
+        {
+            const double a = -juce::MathConstants<double>::twoPi * i / fftSize;
+
+            if (i < half / 2)
+            {
+                twiddleRe[(size_t) i] = (float) std::cos (2.0 * a);
+                twiddleIm[(size_t) i] = (float) std::sin (2.0 * a);
+            }
+
+            splitRe[(size_t) i] = (float) std::cos (a);
+            splitIm[(size_t) i] = (float) std::sin (a);
+
+            int r = 0;
+            for (int b = 0; b < Order - 1; ++b)
+                r |= ((i >> b) & 1) << (Order - 2 - b);
+
+            bitReversed[(size_t) i] = r;
+        }
+    }
+
+    // Transforms count (<= Lanes) frames of fftSize samples, multiplied by window if it isn't
+    // null, and writes numBins powers |X[k]|^2 for each; unused lanes are run silent.
+    void performPower (const float* const* frames, int count, const float* window,
+                       float* const* powerOut) noexcept
+    {
+        jassert (count > 0 && count <= Lanes);
+
+        float* re = laneRe.data();
+        float* im = laneIm.data();
+
+        // Window, pack and bit-reverse each frame into its lane
+        for (int l = 0; l < Lanes; ++l)
+        {
+            const float* x = l < count ? frames[l] : nullptr;
+
+            for (int n = 0; n < half; ++n)
+            {
+                const int d = bitReversed[(size_t) n] * Lanes + l;
+
+                if (x == nullptr)
+                {
+                    re[d] = im[d] = 0.0f;
+                }
+                else if (window != nullptr)
+                {
+                    re[d] = x[2 * n]     * window[2 * n];
+                    im[d] = x[2 * n + 1] * window[2 * n + 1];
+                }
+                else
+                {
+                    re[d] = x[2 * n];
+                    im[d] = x[2 * n + 1];
+                }
+            }
+        }
+
+        for (int span = 1, stride = half / 2; span < half; span *= 2, stride /= 2)
+        {
+            for (int start = 0; start < half; start += 2 * span)
+            {
+                for (int k = 0; k < span; ++k)
+                {
+                    const float wr = twiddleRe[(size_t) (k * stride)];
+                    const float wi = twiddleIm[(size_t) (k * stride)];
+                    float* ar = re + (start + k) * Lanes;
+                    float* ai = im + (start + k) * Lanes;
+                    float* br = ar + span * Lanes;
+                    float* bi = ai + span * Lanes;
+
+                    for (int l = 0; l < Lanes; ++l)
+                    {
+                        const float tr = br[l] * wr - bi[l] * wi;
+                        const float ti = br[l] * wi + bi[l] * wr;
+                        br[l] = ar[l] - tr;
+                        bi[l] = ai[l] - ti;
+                        ar[l] += tr;
+                        ai[l] += ti;
+                    }
+                }
+            }
+        }
+
+        // Untangle: X[k] = E[k] + e^(-2 pi j k / N) O[k], with E, O from Z[k] and Z*[half - k]
+        for (int k = 0; k < half; ++k)
+        {
+            const float* zr = re + k * Lanes;
+            const float* zi = im + k * Lanes;
+            const float* cr = re + ((half - k) & (half - 1)) * Lanes;
+            const float* ci = im + ((half - k) & (half - 1)) * Lanes;
+            const float wr = splitRe[(size_t) k], wi = splitIm[(size_t) k];
+
+            float power[Lanes];
+
+            for (int l = 0; l < Lanes; ++l)
+            {
+                const float evenRe = 0.5f * (zr[l] + cr[l]), evenIm =  0.5f * (zi[l] - ci[l]);
+                const float oddRe  = 0.5f * (zi[l] + ci[l]), oddIm  = -0.5f * (zr[l] - cr[l]);
+                const float xr = evenRe + wr * oddRe - wi * oddIm;
+                const float xi = evenIm + wr * oddIm + wi * oddRe;
+                power[l] = xr * xr + xi * xi;
+            }
+
+            for (int l = 0; l < count; ++l)
+                powerOut[l][k] = power[l];
+        }
+    }
+
+private:
+    static constexpr int half = fftSize / 2;    // length of the complex FFT behind each real one
+
+    std::vector<float> laneRe, laneIm;          // [half][Lanes]: one frame per lane
+    std::vector<float> twiddleRe, twiddleIm;    // e^(-2 pi j i / half)
+    std::vector<float> splitRe, splitIm;        // e^(-2 pi j i / fftSize)
+    std::vector<int>   bitReversed;
+
+    JUCE_DECLARE_NON_COPYABLE (LaneRealFFT)
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstdint>
+#include <limits>
+
+// Linear mapping between spectrum levels in dB and 8- or 16-bit codes, used to shrink frames on
+// their way from the analysis thread to the UI. Code 0 is minDb, the largest code is maxDb;
+// levels outside the range are clamped. Both directions are branch-free and vectorise.
+struct LevelQuantiser
+{
+    float minDb = -80.0f, maxDb = 0.0f;
+
+    template <typename Code>
+    void encode (const float* levels, Code* codes, int num) const noexcept
+    {
+        constexpr float maxCode = (float) std::numeric_limits<Code>::max();
+        const float scale = maxCode / (maxDb - minDb);
+
+        for (int i = 0; i < num; ++i)
+            codes[i] = (Code) (juce::jmin (maxCode, juce::jmax (0.0f, (levels[i] - minDb) * scale)) + 0.5f);
+    }
+
+    template <typename Code>
+    void decode (const Code* codes, float* levels, int num) const noexcept
+    {
+        const float step = (maxDb - minDb) / (float) std::numeric_limits<Code>::max();
+
+        for (int i = 0; i < num; ++i)
+            levels[i] = minDb + (float) codes[i] * step;
+    }
+};
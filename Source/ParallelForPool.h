@@ -0,0 +1,107 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+
+// Small fixed pool for fanning independent per-channel work out across cores.
+// parallelFor() wakes up to numTasks - 1 helpers and works alongside them; every participant
+// claims the next unstarted task from a shared atomic counter, so a thread that finishes early
+// steals the remaining channels instead of idling. Only the calling (analysis) thread waits for
+// completion; the audio thread never touches the pool.
+class ParallelForPool
+{
+public:
+    ParallelForPool() = default;
+    ~ParallelForPool()                          { setNumWorkers (0); }
+
+    // Not real-time safe: starts / stops threads.
+    void setNumWorkers (int numWorkers, juce::Thread::Priority priority = juce::Thread::Priority::high)
+    {
+        for (auto* w : workers)
+            w->signalThreadShouldExit();
+
+        for (auto* w : workers)
+        {
+            w->notify();
+            w->stopThread (1000);
+        }
+
+        workers.clear();
+
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            auto* w = workers.add (new Worker (*this, i));
+            w->startThread (priority);
+        }
+    }
+
+    int getNumWorkers() const noexcept          { return workers.size(); }
+
+    // Runs task (i) for every i in [0, numTasks) and returns once all of them have finished.
+    void parallelFor (int numTasks, const std::function<void (int)>& task)
+    {
+        const int helpers = juce::jmin (workers.size(), numTasks - 1);
+
+        if (helpers <= 0)
+        {
+            for (int i = 0; i < numTasks; ++i)
+                task (i);
+
+            return;
+        }
+
+        currentTask = &task;
+        totalTasks  = numTasks;
+        nextTask.store (0, std::memory_order_relaxed);
+        pendingHelpers.store (helpers, std::memory_order_release);
+
+        for (int i = 0; i < helpers; ++i)
+            workers.getUnchecked (i)->notify();
+
+        runTasks();
+        allHelpersDone.wait (-1);
+    }
+
+private:
+    struct Worker : public juce::Thread
+    {
+        Worker (ParallelForPool& p, int index)
+            : juce::Thread ("Spectrogram Analysis " + juce::String (index + 1)), pool (p) {}
+
+        void run() override
+        {
+            for (;;)
+            {
+                wait (-1);
+
+                if (threadShouldExit())
+                    return;
+
+                pool.runTasks();
+
+                if (pool.pendingHelpers.fetch_sub (1, std::memory_order_acq_rel) == 1)
+                    pool.allHelpersDone.signal();
+            }
+        }
+
+        ParallelForPool& pool;
+    };
+
+    juce::OwnedArray<Worker> workers;
+    const std::function<void (int)>* currentTask = nullptr;
+    int totalTasks = 0;
+
+    alignas (64) std::atomic<int> nextTask { 0 };
+    alignas (64) std::atomic<int> pendingHelpers { 0 };
+    juce::WaitableEvent allHelpersDone;
+
+    void runTasks()
+    {
+        for (int i = nextTask.fetch_add (1, std::memory_order_relaxed); i < totalTasks;
+                 i = nextTask.fetch_add (1, std::memory_order_relaxed))
+            (*currentTask) (i);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (ParallelForPool)
+};
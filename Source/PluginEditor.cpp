@@ -1,5 +1,6 @@
 #include "PluginEditor.h"
 #include <cmath>
+#include <utility>
 
 // ======================= SpectrogramComponent ==========================
 SpectrogramComponent::SpectrogramComponent (TelevisionAudioProcessor& p)
@@ -16,11 +17,15 @@ SpectrogramComponent::SpectrogramComponent (TelevisionAudioProcessor& p)
         s.setRange (0.0, 1.0, 0.0);
         s.setAlpha (0.0f);
         addAndMakeVisible (s);
+
+        // The knob faces live in the cached front layer and only the pointers are drawn live,
+        // so a moving knob just repaints its own bounds
+        s.onValueChange = [this, &s] { repaint (s.getBounds()); };
     };
 
     setupSlider (sensitivitySlider);
     setupSlider (sineLevelSlider);
-    setupSlider (dummySpeedSlider);
+    setupSlider (speedSlider);
 
     sensAttach = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audio.apvts, "sensitivity", sensitivitySlider);
@@ -28,13 +33,24 @@ SpectrogramComponent::SpectrogramComponent (TelevisionAudioProcessor& p)
     sineAttach = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audio.apvts, "sineLevel", sineLevelSlider);
 
-    startTimerHz (45);
+    speedAttach = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audio.apvts, "speed", speedSlider);
 }
 
 void SpectrogramComponent::resized()
 {
     layoutRects();
     rebuildOverlayIfNeeded();
+
+    chromeLayer = {};
+    frontLayer  = {};
+    updateViewSize();
+}
+
+void SpectrogramComponent::updateViewSize()
+{
+    compositor.setViewSize ((int) ((float) spectrumBounds.getWidth()  * layerScale),
+                            (int) ((float) spectrumBounds.getHeight() * layerScale));
 }
 
 void SpectrogramComponent::layoutRects()
@@ -48,6 +64,21 @@ void SpectrogramComponent::layoutRects()
     const int panelW = juce::jmax (24, screenBounds.getWidth() / 9);
     panelBounds = screenBounds.withX (screenBounds.getRight() - panelW)
                               .withWidth (panelW);
+    spectrumBounds = screenBounds.withRight (panelBounds.getX());
+
+    // Knobs sit in the lower part of the panel, below the logo
+    auto knobZone = panelBounds.withTrimmedTop (panelBounds.getHeight() / 4);
+    knobZone = knobZone.removeFromBottom ((int) (knobZone.getHeight() * 0.65f));
+    const int knobDiam = juce::jmax (12, panelBounds.getWidth() - 26);
+    const int spacing  = (knobZone.getHeight() - (3 * knobDiam)) / 4;
+    int ky             = knobZone.getY() + spacing;
+    const int cx       = knobZone.getCentreX();
+
+    for (auto* s : { &sensitivitySlider, &sineLevelSlider, &speedSlider })
+    {
+        s->setBounds (cx - knobDiam / 2, ky, knobDiam, knobDiam);
+        ky += knobDiam + spacing;
+    }
 }
 
 void SpectrogramComponent::rebuildOverlayIfNeeded()
@@ -76,93 +107,122 @@ void SpectrogramComponent::rebuildOverlayIfNeeded()
         g.fillRect (0, y, specW, 1);
 }
 
-juce::Colour SpectrogramComponent::dbToWhitePink (float db, float dynDb)
+void SpectrogramComponent::mouseWheelMove (const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel)
 {
-    float t = juce::jlimit (0.0f, 1.0f, (db + dynDb) / dynDb);
-    t *= (float) sensitivitySlider.getValue();
-
-    auto lerp = [] (float a, float b, float u) { return a + (b - a) * u; };
-    float r = 1.0f;
-    float g = lerp (1.0f, 0.20f, t);
-    float b = lerp (1.0f, 0.65f, t);
-    return juce::Colour::fromFloatRGBA (r, g, b, 1.0f);
+    if (! spectrumBounds.contains (e.getPosition()) || wheel.isInertial || wheel.deltaY == 0.0f)
+        return;
+
+    auto view = compositor.getHistoryView();
+    const int zoom = juce::jlimit (0, HistoryStore::numLevels - 1, view.zoom + (wheel.deltaY < 0.0f ? 1 : -1));
+    if (zoom == view.zoom)
+        return;
+
+    // The right edge stays put; the compositor aligns it to the new step
+    view.zoom = zoom;
+    compositor.setHistoryView (view);
 }
 
-void SpectrogramComponent::updateSpectrogramImage()
+void SpectrogramComponent::mouseDown (const juce::MouseEvent&)
 {
-    std::vector<float> latestSlice;
-    audio.getLatestSpectrum (latestSlice);
-    if (latestSlice.empty())
-        return;
+    const auto view = compositor.getHistoryView();
+    HistoryStore::Shape shape;
+    dragStartEnd = view.followLive ? audio.getHistory().getNumColumns (shape) : view.end;
+}
 
-    const int numBins = (int) latestSlice.size();
-    const float dynDb = audio.getDynDb();
+void SpectrogramComponent::mouseDrag (const juce::MouseEvent& e)
+{
+    if (! spectrumBounds.contains (e.getMouseDownPosition()))
+        return;
 
-    if (spectrogramImage.getWidth()  != audio.getTimeBins()
-     || spectrogramImage.getHeight() != numBins)
-        spectrogramImage = juce::Image (juce::Image::RGB, audio.getTimeBins(), numBins, true);
+    // Dragging right pulls older hops into view, one image pixel per 2^zoom screen columns
+    auto view = compositor.getHistoryView();
+    HistoryStore::Shape shape;
+    const auto numColumns = (int64_t) audio.getHistory().getNumColumns (shape);
+    const auto pixels     = (int64_t) juce::roundToInt ((float) e.getDistanceFromDragStartX() * layerScale);
+    const auto target     = (int64_t) dragStartEnd - pixels * ((int64_t) audio.getHopsPerColumn() << view.zoom);
 
-    const int w = spectrogramImage.getWidth();
-    const int h = spectrogramImage.getHeight();
+    view.followLive = target >= numColumns;
+    view.end = (uint64_t) juce::jlimit ((int64_t) 0, numColumns, target);
+    compositor.setHistoryView (view);
+}
 
-    // Scroll and clear new column to white
-    spectrogramImage.moveImageSection (0, 0, 1, 0, w - 1, h);
-    juce::Graphics g (spectrogramImage);
-    g.setColour (juce::Colours::white);
-    g.fillRect (w - 1, 0, 1, h);
+void SpectrogramComponent::mouseDoubleClick (const juce::MouseEvent& e)
+{
+    if (! spectrumBounds.contains (e.getPosition()))
+        return;
 
-    const int x = w - 1;
-    // Input spectrum (pink/white)
-    for (int y = 0; y < numBins; ++y)
-    {
-        const float mag = latestSlice[(size_t) y];
-        const float db  = (mag > 1.0e-12f ? 20.0f * std::log10 (mag) : -dynDb * 2.0f);
-        g.setColour (dbToWhitePink (db, dynDb));
-        g.fillRect (x, (numBins - 1) - y, 1, 1);
-    }
+    compositor.setHistoryView ({});
+}
 
-    // Overlay sine spectrum (white → green depending on level)
-    std::vector<float> sineSlice;
-    audio.getLatestSineSpectrum (sineSlice);
-    if (! sineSlice.empty())
+// Called once per display refresh. Asks the compositor for the next picture and repaints only
+// once it has published one, so the message thread never decodes or colours a column. Idling
+// follows the input, not the transport: a host that stops calling processBlock, a silent input
+// or a minimised window costs next to nothing, while live input keeps drawing when stopped.
+void SpectrogramComponent::onVBlank()
+{
+    if (auto* peer = getPeer())
     {
-        const float dynDb = audio.getDynDb();
-        for (int y = 0; y < numBins; ++y)
+        if (peer->isMinimised())
         {
-            const float mag = sineSlice[(size_t) y];
-            if (mag > 1.0e-12f)
-            {
-                float db = 20.0f * std::log10 (mag);
-                if (db > -60.0f)
-                {
-                    // map dB to 0–1 range
-                    float t = juce::jlimit (0.0f, 1.0f, (db + dynDb) / dynDb);
-
-                    // interpolate white → green
-                    float r = 1.0f;
-                    float gcol = 1.0f - (1.0f - 0.0f) * t; // fades red down
-                    float gval = juce::jmap (t, 0.0f, 1.0f, 1.0f, 1.0f); // stays 1
-                    float bcol = 1.0f - t; // fades blue down
-
-                    juce::Colour c = juce::Colour::fromFloatRGBA (r * (1.0f - t),
-                                                                  gval,
-                                                                  bcol,
-                                                                  1.0f);
-                    // simpler: lerp white→green
-                    c = juce::Colour::fromFloatRGBA (1.0f - t, 1.0f, 1.0f - t, 1.0f);
-
-                    g.setColour (c);
-                    g.fillRect (x, (numBins - 1) - y, 1, 1);
-                }
-            }
+            wasMinimised = true;
+            return;
         }
     }
+
+    if (std::exchange (wasMinimised, false))
+        compositor.resume();
+
+    compositor.requestFrame();
+
+    const auto dropped = compositor.getNumFramesDropped();
+
+    // The only place a new picture is taken, so other repaints (e.g. a knob moving) blit the
+    // one already shown instead of consuming the next
+    if (compositor.hasNewPicture())
+        shownPicture = &compositor.getPicture();
+    else if (dropped == shownFramesDropped)
+        return;
+
+    shownFramesDropped = dropped;
+    repaint (spectrumBounds);
 }
 
-void SpectrogramComponent::timerCallback()
+// Lane tiles laid out as SpectrogramCompositor::getGridColumns() describes
+void SpectrogramComponent::drawSpectrogramTiles (juce::Graphics& g, juce::Rectangle<int> area,
+                                                 const SpectrogramCompositor::Picture& picture)
 {
-    updateSpectrogramImage();
-    repaint();
+    const auto& image = picture.image;
+    const int lanes = juce::jlimit (1, image.getHeight(), picture.numLanes);
+    const int cols  = SpectrogramCompositor::getGridColumns (lanes);
+    const int w     = image.getWidth();
+    const int laneH = image.getHeight() / lanes;
+    const int writeColumn = picture.writeColumn;
+    const float toLogical = 1.0f / layerScale;
+
+    for (int lane = 0; lane < lanes; ++lane)
+    {
+        const int c = lane % cols, r = lane / cols;
+        const float x0 = (float) area.getX() + (float) (c * w)     * toLogical;
+        const float y0 = (float) area.getY() + (float) (r * laneH) * toLogical;
+
+        // Tiles are already at physical size, so each half is a straight copy
+        auto blit = [&] (int srcX, int srcW, float destX)
+        {
+            if (srcW > 0)
+                g.drawImageTransformed (image.getClippedImage ({ srcX, lane * laneH, srcW, laneH }),
+                                        juce::AffineTransform::scale (toLogical).translated (destX, y0));
+        };
+
+        // Oldest columns (from the write cursor on) on the left, newest (before it) on the right
+        blit (writeColumn, w - writeColumn, x0);
+        blit (0, writeColumn, x0 + (float) (w - writeColumn) * toLogical);
+
+        if (lanes > 2)
+        {
+            g.setColour (juce::Colours::black.withAlpha (0.25f));
+            g.drawRect (x0, y0, (float) w * toLogical, (float) laneH * toLogical, 1.0f);
+        }
+    }
 }
 
 void SpectrogramComponent::drawControlPanel (juce::Graphics& g)
@@ -184,15 +244,13 @@ void SpectrogramComponent::drawControlPanel (juce::Graphics& g)
                            juce::RectanglePlacement::centred, false);
    #endif
 
-    auto knobZone = workingArea.removeFromBottom (workingArea.getHeight() * 0.65f);
-    const int knobDiam = juce::jmax (12, workingArea.getWidth() - 26);
-    const int spacing  = (knobZone.getHeight() - (3 * knobDiam)) / 4;
-    int ky             = knobZone.getY() + spacing;
-    const int cx       = knobZone.getCentreX();
-    const int r        = knobDiam / 2;
-
-    auto drawKnob = [&] (int cy, juce::Slider& slider)
+    auto drawKnob = [&] (juce::Slider& slider)
     {
+        const auto bounds = slider.getBounds();
+        const int cx = bounds.getCentreX(), cy = bounds.getCentreY();
+        const int knobDiam = bounds.getWidth();
+        const int r = knobDiam / 2;
+
         juce::Colour c1 = juce::Colour::fromRGB (70, 70, 70);
         juce::Colour c2 = juce::Colour::fromRGB (110, 110, 110);
         juce::ColourGradient kg (c2, (float) cx, (float) (cy - r),
@@ -203,9 +261,6 @@ void SpectrogramComponent::drawControlPanel (juce::Graphics& g)
         g.setColour (juce::Colours::black);
         g.drawEllipse ((float) (cx - r), (float) (cy - r), (float) knobDiam, (float) knobDiam, 2.0f);
 
-        const float minA = juce::MathConstants<float>::pi * 0.75f;
-        const float maxA = juce::MathConstants<float>::pi * 2.25f;
-
         auto tick = [&] (float a)
         {
             const float inner = r * 1.05f;
@@ -216,31 +271,51 @@ void SpectrogramComponent::drawControlPanel (juce::Graphics& g)
                         (float) cx + outer * std::cos (a),
                         (float) cy + outer * std::sin (a), 2.0f);
         };
-        tick (minA);
-        tick (maxA);
+        tick (knobMinAngle);
+        tick (knobMaxAngle);
+    };
 
-        float angle = juce::jmap ((float) slider.getValue(), 0.0f, 1.0f, minA, maxA);
-        const float len = r * 0.65f;
-        g.setColour (juce::Colours::white);
-        g.drawLine ((float) cx, (float) cy,
-                    (float) cx + len * std::cos (angle),
-                    (float) cy + len * std::sin (angle), 2.0f);
+    drawKnob (sensitivitySlider);
+    drawKnob (sineLevelSlider);
+    drawKnob (speedSlider);
+}
 
-        slider.setBounds (juce::Rectangle<int> (cx - r, cy - r, knobDiam, knobDiam));
-    };
+// The only part of the panel that moves, drawn over the cached faces on every paint
+void SpectrogramComponent::drawKnobPointers (juce::Graphics& g)
+{
+    g.setColour (juce::Colours::white);
+
+    for (auto* slider : { &sensitivitySlider, &sineLevelSlider, &speedSlider })
+    {
+        const auto bounds = slider->getBounds();
+        const float cx = (float) bounds.getCentreX(), cy = (float) bounds.getCentreY();
+        const float len = (float) (bounds.getWidth() / 2) * 0.65f;
+        const float angle = juce::jmap ((float) slider->getValue(), 0.0f, 1.0f, knobMinAngle, knobMaxAngle);
 
-    drawKnob (ky + r, sensitivitySlider); ky += knobDiam + spacing;
-    drawKnob (ky + r, sineLevelSlider);   ky += knobDiam + spacing;
-    drawKnob (ky + r, dummySpeedSlider);
+        g.drawLine (cx, cy, cx + len * std::cos (angle), cy + len * std::sin (angle), 2.0f);
+    }
 }
 
-void SpectrogramComponent::paint (juce::Graphics& g)
+juce::Path SpectrogramComponent::getGlassPath() const
+{
+    juce::Path glass;
+    glass.addRoundedRectangle (screenBounds.toFloat(), getBodyRadius() * 0.55f);
+    return glass;
+}
+
+float SpectrogramComponent::getBodyRadius() const
+{
+    return juce::jmin (crtBounds.getWidth(), crtBounds.getHeight()) * 0.08f;
+}
+
+// Everything behind the picture: body, stand, screen inlay and blank glass
+void SpectrogramComponent::drawChrome (juce::Graphics& g)
 {
     g.fillAll (juce::Colours::white);
 
     // ===== CRT body =====
     juce::Path body;
-    const float bodyRadius = juce::jmin (crtBounds.getWidth(), crtBounds.getHeight()) * 0.08f;
+    const float bodyRadius = getBodyRadius();
     body.addRoundedRectangle (crtBounds.toFloat(), bodyRadius);
 
     juce::ColourGradient outerGrad (juce::Colour::fromRGB (245, 245, 245),
@@ -287,34 +362,83 @@ void SpectrogramComponent::paint (juce::Graphics& g)
     g.setColour (juce::Colour::fromRGB (210, 210, 210));
     g.fillRoundedRectangle (inlay.toFloat(), bodyRadius * 0.5f);
 
-    const float screenRadius = bodyRadius * 0.55f;
-    juce::Path glass; glass.addRoundedRectangle (screenBounds.toFloat(), screenRadius);
-
     g.setColour (juce::Colours::white);
-    g.fillPath (glass);
+    g.fillPath (getGlassPath());
+}
+
+// Everything in front of the picture: the control panel and the glass rim
+void SpectrogramComponent::drawFront (juce::Graphics& g)
+{
+    const auto glass = getGlassPath();
 
     g.saveState();
     g.reduceClipRegion (glass);
+    drawControlPanel (g);
+    g.restoreState();
+
+    g.setColour (juce::Colours::black);
+    g.strokePath (glass, juce::PathStrokeType (4.0f));
+}
 
-    auto specBounds = screenBounds.withRight (panelBounds.getX());
-    if (! spectrogramImage.isNull())
+// Renders a layer at the display's physical resolution, so cached chrome stays sharp on HiDPI
+juce::Image SpectrogramComponent::renderLayer (juce::Image::PixelFormat format,
+                                               void (SpectrogramComponent::*draw) (juce::Graphics&))
+{
+    juce::Image layer (format, juce::jmax (1, juce::roundToInt (getWidth()  * layerScale)),
+                               juce::jmax (1, juce::roundToInt (getHeight() * layerScale)), true);
+    juce::Graphics lg (layer);
+    lg.addTransform (juce::AffineTransform::scale (layerScale));
+    (this->*draw) (lg);
+    return layer;
+}
+
+void SpectrogramComponent::paint (juce::Graphics& g)
+{
+    // Chrome and panel come from cached layers; only the picture between them and the knob
+    // pointers on top are drawn live
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (scale != layerScale)
     {
-        g.drawImageWithin (spectrogramImage,
-                           specBounds.getX(), specBounds.getY(),
-                           specBounds.getWidth(), specBounds.getHeight(),
-                           juce::RectanglePlacement::stretchToFit,
-                           false);
+        layerScale = scale;
+        chromeLayer = {};
+        frontLayer  = {};
+        updateViewSize();
     }
 
+    if (chromeLayer.isNull())
+        chromeLayer = renderLayer (juce::Image::RGB, &SpectrogramComponent::drawChrome);
+
+    if (frontLayer.isNull())
+        frontLayer = renderLayer (juce::Image::ARGB, &SpectrogramComponent::drawFront);
+
+    const auto area = getLocalBounds().toFloat();
+    g.drawImage (chromeLayer, area);
+
+    g.saveState();
+    g.reduceClipRegion (getGlassPath());
+
+    // Only ever a blit: the compositor has already drawn every column at physical size
+    if (shownPicture != nullptr && ! shownPicture->image.isNull())
+        drawSpectrogramTiles (g, spectrumBounds, *shownPicture);
+
     if (! overlayImage.isNull())
-        g.drawImageAt (overlayImage, specBounds.getX(), specBounds.getY());
+        g.drawImageAt (overlayImage, spectrumBounds.getX(), spectrumBounds.getY());
 
-    drawControlPanel (g);
+    // Columns lost to a full frame queue (the editor fell behind), so gaps are never silent
+    if (shownFramesDropped > 0)
+    {
+        g.setColour (juce::Colours::black.withAlpha (0.55f));
+        g.setFont (11.0f);
+        g.drawText (juce::String ((juce::int64) shownFramesDropped) + " columns dropped",
+                    spectrumBounds.reduced (8, 6), juce::Justification::bottomLeft, false);
+    }
 
     g.restoreState();
 
-    g.setColour (juce::Colours::black);
-    g.strokePath (glass, juce::PathStrokeType (4.0f));
+    g.drawImage (frontLayer, area);
+
+    g.reduceClipRegion (getGlassPath());
+    drawKnobPointers (g);
 }
 
 // ======================= Editor (window) ================================
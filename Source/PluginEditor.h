@@ -2,6 +2,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "SpectrogramCompositor.h"
 
 #if __has_include("BinaryData.h")
   #include "BinaryData.h"
@@ -10,22 +11,40 @@
   #define HAS_FROG_PNG 0
 #endif
 
-class SpectrogramComponent : public juce::Component,
-                             private juce::Timer
+class SpectrogramComponent : public juce::Component
 {
 public:
     explicit SpectrogramComponent (TelevisionAudioProcessor&);
+    ~SpectrogramComponent() override = default;
 
     void paint    (juce::Graphics&) override;
     void resized  () override;
 
+    // History navigation: the wheel zooms time out / in by powers of two, dragging scrolls
+    // back through the history, a double-click returns to the live 1:1 view
+    void mouseWheelMove   (const juce::MouseEvent&, const juce::MouseWheelDetails&) override;
+    void mouseDown        (const juce::MouseEvent&) override;
+    void mouseDrag        (const juce::MouseEvent&) override;
+    void mouseDoubleClick (const juce::MouseEvent&) override;
+
 private:
     TelevisionAudioProcessor& audio;
 
-    juce::Image spectrogramImage { juce::Image::RGB, TelevisionAudioProcessor::timeCols,
-                                   TelevisionAudioProcessor::numBins, true };
+    // Composes the picture on its own thread; paint() only blits the newest one it published
+    SpectrogramCompositor compositor { audio };
+    const SpectrogramCompositor::Picture* shownPicture = nullptr;  // taken in onVBlank() only
+
+    uint64_t dragStartEnd = 0;          // history view's right edge when a drag began
+
+    uint64_t shownFramesDropped = 0;    // as last drawn in the corner of the picture
+    bool wasMinimised = false;
 
-    juce::Rectangle<int> crtBounds, screenBounds, panelBounds;
+    juce::Rectangle<int> crtBounds, screenBounds, panelBounds, spectrumBounds;
+
+    // Static layers cached at the display's pixel scale: everything behind the picture, and the
+    // panel and glass rim in front of it. Cleared on resize or a change of scale only.
+    juce::Image chromeLayer, frontLayer;
+    float layerScale = 1.0f;
 
     juce::Image overlayImage;
     int lastOverlayW = 0, lastOverlayH = 0;
@@ -33,18 +52,30 @@ private:
     juce::Image frogLogo;
 
     // Knobs
-    juce::Slider sensitivitySlider, sineLevelSlider, dummySpeedSlider;
+    juce::Slider sensitivitySlider, sineLevelSlider, speedSlider;
+    static constexpr float knobMinAngle = juce::MathConstants<float>::pi * 0.75f;
+    static constexpr float knobMaxAngle = juce::MathConstants<float>::pi * 2.25f;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> sensAttach;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> sineAttach;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> speedAttach;
+
+    // Drives the picture in step with the display; JUCE only calls it while the editor is on screen
+    juce::VBlankAttachment vBlank { this, [this] { onVBlank(); } };
 
-    void timerCallback() override;
-    void updateSpectrogramImage();
+    void onVBlank();
+    void updateViewSize();
     void layoutRects();
     void rebuildOverlayIfNeeded();
     void drawControlPanel (juce::Graphics& g);
-
-    juce::Colour dbToWhitePink (float db, float dynDb);
+    void drawKnobPointers (juce::Graphics& g);
+    void drawChrome (juce::Graphics& g);
+    void drawFront (juce::Graphics& g);
+    juce::Image renderLayer (juce::Image::PixelFormat format, void (SpectrogramComponent::*draw) (juce::Graphics&));
+    juce::Path getGlassPath() const;
+    float getBodyRadius() const;
+    void drawSpectrogramTiles (juce::Graphics& g, juce::Rectangle<int> area,
+                               const SpectrogramCompositor::Picture& picture);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrogramComponent)
 };
@@ -1,22 +1,37 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+static_assert (TelevisionAudioProcessor::minFftOrder == SpectrogramEngineDetail::minOrder
+            && TelevisionAudioProcessor::maxFftOrder == SpectrogramEngineDetail::maxOrder,
+               "fftSize parameter range must match the instantiated engines");
+
 TelevisionAudioProcessor::TelevisionAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
     : AudioProcessor (BusesProperties()
                         .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
                         .withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
-      apvts (*this, nullptr, "PARAMS", createParameterLayout()),
-      window ((size_t) fftSize, juce::dsp::WindowingFunction<float>::hann)
+      apvts (*this, nullptr, "PARAMS", createParameterLayout())
 #else
-    : apvts (*this, nullptr, "PARAMS", createParameterLayout()),
-      window ((size_t) fftSize, juce::dsp::WindowingFunction<float>::hann)
+    : apvts (*this, nullptr, "PARAMS", createParameterLayout())
 #endif
 {
-    latestMagnitudes.assign (numBins, 0.0f);
-    latestSineMagnitudes.assign (numBins, 0.0f);
-    monoFifo.clear();
-    sineFifo.clear();
+    fftSizeParam = apvts.getRawParameterValue ("fftSize");
+    overlapParam = apvts.getRawParameterValue ("overlap");
+    channelViewParam = apvts.getRawParameterValue ("channelView");
+    speedParam = apvts.getRawParameterValue ("speed");
+    speedReductionParam = apvts.getRawParameterValue ("speedReduction");
+    frameFormatParam = apvts.getRawParameterValue ("frameFormat");
+
+    // Hand-off buffers are sized for the largest FFT so they never reallocate while in use
+    spectrumFrames.prepare (frameArenaBytes, frameQueueDepth);
+    stereoLevels.assign ((size_t) maxNumBins * 2, 0.0f);
+    columnFolder.prepare (maxNumBins * maxChannels);
+    historyCodes.assign ((size_t) (maxNumBins * maxChannels), 0);
+    historyQuantiser = getLevelQuantiser (FrameQueue::Format::uint8);
+    latestSineLevels.initialise ([] (std::vector<float>& frame) { frame.assign (maxNumBins, levelFloorDb); });
+
+    updateAnalysisSetup();
+    prepareBuffers (512);
 }
 
 TelevisionAudioProcessor::~TelevisionAudioProcessor() = default;
@@ -34,147 +49,370 @@ TelevisionAudioProcessor::createParameterLayout()
         "sineLevel", "Sine Level",
         juce::NormalisableRange<float>(0.0f, 1.0f, 0.0f, 1.0f), 0.0f));
 
+    juce::StringArray fftSizeChoices;
+    for (int order = minFftOrder; order <= maxFftOrder; ++order)
+        fftSizeChoices.add (juce::String (1 << order));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        "fftSize", "FFT Size", fftSizeChoices, defaultFftOrder - minFftOrder));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        "overlap", "Overlap", juce::StringArray { "50%", "75%", "87.5%", "93.75%" }, 1));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        "channelView", "Channel View",
+        juce::StringArray { "Mono", "Left / Right", "Mid / Side", "Difference", "All Channels" }, 0));
+
+    // Order matches SpectrogramPalette::Palette
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        "palette", "Palette", juce::StringArray { "White / Pink", "Viridis", "Magma", "Greyscale" }, 0));
+
+    // Order matches FrequencyAxisMap::Axis
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        "frequencyAxis", "Frequency Axis", juce::StringArray { "Linear", "Log", "Mel" }, 1));
+
+    // Scroll speed in speedSteps steps: 1 draws every hop as its own column, each step down
+    // halves the rate, to maxHopsPerColumn hops per column at 0. The default folds 4 hops.
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        "speed", "Speed",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 1.0f / (float) speedSteps, 1.0f), 2.0f / 3.0f));
+
+    // Order matches ColumnFolder::Reduction
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        "speedReduction", "Speed Reduction", juce::StringArray { "Max", "Mean", "RMS" }, 0));
+
+    // Order matches FrameQueue::Format
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        "frameFormat", "Frame Format", juce::StringArray { "Float", "16-bit", "8-bit" }, 2));
+
     return { params.begin(), params.end() };
 }
 
-void TelevisionAudioProcessor::prepareToPlay (double sampleRate, int)
+void TelevisionAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlockExpected)
 {
+    analysisThread.stop();
+
     currentSR = sampleRate;
-    monoFifo.clear();
-    sineFifo.clear();
-    samplesSinceLastFFT = 0;
-    phase = 0.0;
+    numInputChannels = juce::jlimit (1, maxChannels, getTotalNumInputChannels());
+    prepareBuffers (samplesPerBlockExpected);
+    toneBank.prepare (sampleRate);
+
+    // Helpers for per-channel analysis; the analysis thread itself is the remaining worker
+    channelPool.setNumWorkers (juce::jlimit (0, maxChannels - 1, juce::SystemStats::getNumCpus() - 2),
+                               analysisThread.getOptions().priority);
+    analysisThread.start();
+}
+
+void TelevisionAudioProcessor::prepareBuffers (int samplesPerBlockExpected)
+{
+    // One full frame plus enough slack for the worker to fall behind by a few blocks
+    // (or ~100 ms, whichever is larger) before the audio thread has to drop samples
+    // The ring always has room for the largest FFT, so a size change never reallocates it
+    const int slack    = juce::jmax (4 * samplesPerBlockExpected, (int) (currentSR.load() * 0.1));
+    const int capacity = maxFftSize + slack;
+    for (auto& fifo : inputFifos)
+        fifo.prepare (capacity);
+
+    // Scratch is sized here so neither thread allocates while running;
+    // host blocks longer than announced are generated in several chunks
+    sineBuffer.assign ((size_t) juce::jmax (samplesPerBlockExpected, 32), 0.0f);
+}
+
+// Runs on the analysis thread (and once from the constructor). The new engine (FFT plan, window
+// and scratch) is fully built before being swapped in, so the audio callback never waits on a
+// size change. The history records one column per hop, so it restarts when the FFT size,
+// overlap or channel view changes, but never for the display speed.
+void TelevisionAudioProcessor::updateAnalysisSetup()
+{
+    const int order   = juce::jlimit (minFftOrder, maxFftOrder,
+                                      minFftOrder + juce::roundToInt (fftSizeParam->load()));
+    const int overlap = juce::jlimit (0, 3, juce::roundToInt (overlapParam->load()));   // 50% .. 93.75%
+
+    channelView = (ChannelView) juce::jlimit (0, 4, juce::roundToInt (channelViewParam->load()));
+    frameFormat = getFrameFormat();
+    frameQuantiser = getLevelQuantiser (frameFormat);
+    const int numEngines = channelView == ChannelView::allChannels ? numInputChannels : 1;
+
+    if (order != fftOrder)
+    {
+        const int newSize = 1 << order;
+        std::vector<std::unique_ptr<AnySpectrogramEngine>> newEngines;
+
+        for (int i = 0; i < numEngines; ++i)
+            newEngines.push_back (createSpectrogramEngine (order));
+
+        std::swap (engines, newEngines);
+
+        fftOrder = order;
+        fftSize  = newSize;
+        numBins  = newSize / 2;
+
+        // Magnitudes grow with N; keep the colour mapping where it was at the default size
+        levelOffsetDb = 20.0f * std::log10 ((float) (1 << defaultFftOrder) / (float) newSize);
+    }
+
+    while ((int) engines.size() < numEngines)
+        engines.push_back (createSpectrogramEngine (order));
+
+    hopSize = fftSize >> (overlap + 1);
+
+    const int numViewChannels = channelView == ChannelView::mono        ? 1
+                              : channelView == ChannelView::allChannels ? numInputChannels : 2;
+    const int speedStep       = juce::jlimit (0, speedSteps, juce::roundToInt (speedParam->load() * (float) speedSteps));
+    const auto reduction      = (ColumnFolder::Reduction) juce::jlimit (0, 2, juce::roundToInt (speedReductionParam->load()));
+    hopsPerColumn.store (maxHopsPerColumn >> speedStep);
+    columnFolder.configure (numBins * numViewChannels, hopsPerColumn.load(), reduction, levelFloorDb);
+}
+
+// Runs on the analysis thread; returns how long to sleep before the next pass
+int TelevisionAudioProcessor::runAnalysisPass()
+{
+    updateAnalysisSetup();
+    runFFTIfReady();
+    updateToneSpectrum();
+
+    // About half a hop, so frames are picked up promptly without spinning
+    return (int) (500.0 * hopSize / currentSR.load());
 }
 
-void TelevisionAudioProcessor::releaseResources() {}
+void TelevisionAudioProcessor::setAnalysisThreadOptions (const AnalysisThread::Options& options)
+{
+    const bool wasRunning = analysisThread.isRunning();
+    analysisThread.stop();
+    analysisThread.setOptions (options);
+
+    if (wasRunning)
+    {
+        channelPool.setNumWorkers (channelPool.getNumWorkers(), options.priority);
+        analysisThread.start();
+    }
+}
+
+void TelevisionAudioProcessor::releaseResources()
+{
+    analysisThread.stop();
+    channelPool.setNumWorkers (0);
+}
 
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool TelevisionAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
-    auto set = layouts.getMainOutputChannelSet();
-    return set == juce::AudioChannelSet::mono() || set == juce::AudioChannelSet::stereo();
+    // Any layout up to maxChannels (5.1, 7.1, 3rd-order ambisonics, ...) passed straight through,
+    // or fewer inputs than outputs, e.g. a mono -> stereo insert on a mono track
+    const auto& in  = layouts.getMainInputChannelSet();
+    const auto& out = layouts.getMainOutputChannelSet();
+    return ! out.isDisabled() && out.size() <= maxChannels && in.size() <= out.size();
 }
 #endif
 
 void TelevisionAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
 {
     juce::ScopedNoDenormals noDenormals;
+    const ScopedNoAllocation noAllocation;
 
     const int numSamples  = buffer.getNumSamples();
     const int numChannels = buffer.getNumChannels();
-    const float* left  = buffer.getReadPointer (0);
-    const float* right = (numChannels > 1 ? buffer.getReadPointer (1) : nullptr);
+
+    // Outputs without an input of their own carry the first input, so mono -> stereo plays in both
+    const int numInputs = juce::jmin (getTotalNumInputChannels(), numChannels);
+    for (int ch = numInputs; ch < numChannels; ++ch)
+    {
+        if (numInputs > 0)
+            buffer.copyFrom (ch, 0, buffer, 0, 0, numSamples);
+        else
+            buffer.clear (ch, 0, numSamples);
+    }
 
     // Feed input FFT
-    pushAudioToFifo (left, right, numSamples);
-    runFFTIfReady();
+    pushAudioToFifos (buffer);
 
     // Sine generation
-    float sineLevel = getSineLevel() * 0.2f; // scaled down
-    double phaseInc = juce::MathConstants<double>::twoPi * 440.0 / currentSR;
+    toneBank.setLevel (getSineLevel() * sineLevelScale);
 
-    std::vector<float> sineBuffer ((size_t) numSamples);
-    for (int i = 0; i < numSamples; ++i)
+    const int chunkSize = (int) sineBuffer.size();
+    for (int start = 0; start < numSamples; start += chunkSize)
     {
-        float s = std::sin (phase) * sineLevel;
-        sineBuffer[(size_t) i] = s;
-
-        phase += phaseInc;
-        if (phase >= juce::MathConstants<double>::twoPi)
-            phase -= juce::MathConstants<double>::twoPi;
+        const int num = juce::jmin (chunkSize, numSamples - start);
+        if (! toneBank.render (sineBuffer.data(), num))
+            break;      // silent: nothing to mix into any channel
 
         for (int ch = 0; ch < numChannels; ++ch)
-            buffer.setSample (ch, i, buffer.getSample (ch, i) + s);
+            juce::FloatVectorOperations::add (buffer.getWritePointer (ch, start), sineBuffer.data(), num);
     }
-
-    // Feed sine FFT
-    pushSineToFifo (sineBuffer.data(), numSamples);
-    runSineFFTIfReady();
 }
 
-void TelevisionAudioProcessor::pushAudioToFifo (const float* left, const float* rightOrNull, int numSamples)
+void TelevisionAudioProcessor::pushAudioToFifos (const juce::AudioBuffer<float>& buffer)
 {
-    monoFifo.resize (monoFifo.size() + (size_t) numSamples);
+    // Audio thread: copy only. If the worker has fallen behind, the overflow is dropped
+    const int numSamples  = buffer.getNumSamples();
+    const int numChannels = juce::jmin (buffer.getNumChannels(), numInputChannels);
 
-    for (int i = 0; i < numSamples; ++i)
-    {
-        const float s = rightOrNull ? 0.5f * (left[i] + rightOrNull[i]) : left[i];
-        monoFifo[monoFifo.size() - numSamples + (size_t) i] = s;
-    }
+    for (int ch = 0; ch < numChannels; ++ch)
+        inputFifos[(size_t) ch].push (buffer.getReadPointer (ch), numSamples);
 
-    samplesSinceLastFFT += numSamples;
+    if (numChannels == 1)
+        inputFifos[1].push (buffer.getReadPointer (0), numSamples);
 }
 
+// Runs on the analysis thread. The engine's order is resolved once per call; the frame loop
+// itself is instantiated per order with compile-time sizes. Every hop already buffered is
+// transformed in one batch (large host blocks deliver several at once); the stereo views
+// already pack two channels into each FFT and go one hop at a time. Hops are transformed even
+// while the editor's queue is full (or no editor is open): every column also goes to the history.
 void TelevisionAudioProcessor::runFFTIfReady()
 {
-    while (samplesSinceLastFFT >= hopSize && (int) monoFifo.size() >= fftSize)
+    std::visit ([this] (auto& typedEngine)
     {
-        const size_t startIdx = monoFifo.size() - fftSize;
+        using Engine = std::decay_t<decltype (typedEngine)>;
+        constexpr int size = Engine::fftSize;
+        constexpr int bins = Engine::numBins;
 
-        std::vector<float> fftData ((size_t) fftSize * 2, 0.0f);
-        for (int i = 0; i < fftSize; ++i)
-            fftData[(size_t) i] = monoFifo[startIdx + (size_t) i];
-
-        window.multiplyWithWindowingTable (fftData.data(), fftSize);
-        fft.performFrequencyOnlyForwardTransform (fftData.data());
+        // Every fed ring advances together, whichever view is active, so switching views
+        // never picks up stale or misaligned audio
+        const int numFed = juce::jmax (2, numInputChannels);
 
+        auto numFramesReady = [this, numFed]
         {
-            std::scoped_lock lk (magLock);
-            if ((int) latestMagnitudes.size() != numBins)
-                latestMagnitudes.assign (numBins, 0.0f);
+            int ready = inputFifos[0].getNumReady();
+            for (int ch = 1; ch < numFed; ++ch)
+                ready = juce::jmin (ready, inputFifos[(size_t) ch].getNumReady());
+
+            return ready < size ? 0 : juce::jmin (Engine::maxBatch, 1 + (ready - size) / hopSize);
+        };
 
-            for (int i = 0; i < numBins; ++i)
-                latestMagnitudes[(size_t) i] = fftData[(size_t) i];
+        for (int numFrames = numFramesReady(); numFrames > 0; numFrames = numFramesReady())
+        {
+            if (channelView == ChannelView::allChannels)
+            {
+                channelPool.parallelFor (numInputChannels, [this, numFrames] (int ch)
+                {
+                    auto& channelEngine = std::get<Engine> (*engines[(size_t) ch]);
+
+                    for (int f = 0; f < numFrames; ++f)
+                        inputFifos[(size_t) ch].peek (channelEngine.getBatchInputBuffer (f), size, f * hopSize);
+
+                    channelEngine.computeBatchDecibels (numFrames, levelOffsetDb);
+                });
+
+                for (int f = 0; f < numFrames; ++f)
+                {
+                    for (int ch = 0; ch < numInputChannels; ++ch)
+                        addHopLevels (ch * bins, std::get<Engine> (*engines[(size_t) ch]).getBatchDecibels (f), bins);
+
+                    endHop (bins, numInputChannels);
+                }
+            }
+            else if (channelView == ChannelView::mono)
+            {
+                float* right = typedEngine.getSecondInputBuffer();
+
+                for (int f = 0; f < numFrames; ++f)
+                {
+                    float* left = typedEngine.getBatchInputBuffer (f);
+                    inputFifos[0].peek (left,  size, f * hopSize);
+                    inputFifos[1].peek (right, size, f * hopSize);
+                    juce::FloatVectorOperations::add (left, right, size);
+                    juce::FloatVectorOperations::multiply (left, 0.5f, size);
+                }
+
+                typedEngine.computeBatchDecibels (numFrames, levelOffsetDb);
+
+                for (int f = 0; f < numFrames; ++f)
+                {
+                    addHopLevels (0, typedEngine.getBatchDecibels (f), bins);
+                    endHop (bins, 1);
+                }
+            }
+            else
+            {
+                numFrames = 1;
+
+                inputFifos[0].peek (typedEngine.getInputBuffer(), size);
+                inputFifos[1].peek (typedEngine.getSecondInputBuffer(), size);
+                typedEngine.computeStereoDecibels (stereoLevels.data(), stereoLevels.data() + bins,
+                                                   channelView == ChannelView::midSide, levelOffsetDb);
+                addHopLevels (0, stereoLevels.data(), 2 * bins);
+                endHop (bins, 2);
+            }
+
+            for (int ch = 0; ch < numFed; ++ch)
+                inputFifos[(size_t) ch].discard (numFrames * hopSize);
         }
+    }, *engines.front());
+}
 
-        monoFifo.erase (monoFifo.begin(), monoFifo.begin() + hopSize);
-        samplesSinceLastFFT -= hopSize;
+// Analysis thread: stores num levels at value offset into a frame from spectrumFrames,
+// converting them to the current transport format.
+void TelevisionAudioProcessor::writeLevels (void* frame, int offset, const float* levels, int num) noexcept
+{
+    switch (frameFormat)
+    {
+        case FrameQueue::Format::uint8:
+            frameQuantiser.encode (levels, static_cast<uint8_t*> (frame) + offset, num);
+            break;
+
+        case FrameQueue::Format::uint16:
+            frameQuantiser.encode (levels, static_cast<uint16_t*> (frame) + offset, num);
+            break;
+
+        case FrameQueue::Format::float32:
+        default:
+            std::copy (levels, levels + num, static_cast<float*> (frame) + offset);
+            break;
     }
 }
 
-void TelevisionAudioProcessor::pushSineToFifo (const float* samples, int numSamples)
+// Analysis thread: num dB levels of the current hop, at offset into its channels
+void TelevisionAudioProcessor::addHopLevels (int offset, const float* levels, int num)
 {
-    sineFifo.resize (sineFifo.size() + (size_t) numSamples);
-    for (int i = 0; i < numSamples; ++i)
-        sineFifo[sineFifo.size() - numSamples + (size_t) i] = samples[i];
+    columnFolder.accumulate (offset, levels, num);
+    historyQuantiser.encode (levels, historyCodes.data() + offset, num);
 }
 
-void TelevisionAudioProcessor::runSineFFTIfReady()
+// Analysis thread: adds the hop to the history and, if it completed a screen column, queues
+// that for the editor. A full queue drops the column, never blocks; the history keeps its hops
+// either way. Each frame's position is the history's running hop count where its column ends.
+void TelevisionAudioProcessor::endHop (int bins, int numChannels)
 {
-    while ((int) sineFifo.size() >= fftSize)
+    history.append (historyCodes.data(), { bins, numChannels, (int) channelView, hopSize });
+
+    if (! columnFolder.endHop())
+        return;
+
+    if (auto* frame = spectrumFrames.beginWrite (bins, numChannels, (int) channelView, frameFormat,
+                                                 history.getNumAppended()))
     {
-        const size_t startIdx = sineFifo.size() - fftSize;
+        writeLevels (frame, 0, columnFolder.getColumn(), bins * numChannels);
+        spectrumFrames.finishWrite();
+    }
+}
 
-        std::vector<float> fftData ((size_t) fftSize * 2, 0.0f);
-        for (int i = 0; i < fftSize; ++i)
-            fftData[(size_t) i] = sineFifo[startIdx + (size_t) i];
+// Runs on the analysis thread. The reference tones' frequencies and level are known exactly,
+// so the overlay is assembled from cached windowed-sinusoid spectra rather than a second FFT.
+void TelevisionAudioProcessor::updateToneSpectrum()
+{
+    auto& frame = latestSineLevels.getWriteFrame();
+    const double sampleRate = currentSR.load();
+    std::fill (frame.begin(), frame.begin() + numBins, 0.0f);
 
-        window.multiplyWithWindowingTable (fftData.data(), fftSize);
-        fft.performFrequencyOnlyForwardTransform (fftData.data());
+    const float level = getSineLevel() * sineLevelScale;
 
+    if (level > 0.0f)
+    {
+        for (int t = 0; t < TestToneBank::maxTones; ++t)
         {
-            std::scoped_lock lk (sineLock);
-            if ((int) latestSineMagnitudes.size() != numBins)
-                latestSineMagnitudes.assign (numBins, 0.0f);
+            const float amplitude = toneBank.getToneAmplitude (t, sampleRate);
+            if (amplitude <= 0.0f)
+                continue;
 
-            for (int i = 0; i < numBins; ++i)
-                latestSineMagnitudes[(size_t) i] = fftData[(size_t) i];
+            const auto& column = toneSpectra.getColumn (toneBank.getFrequency (t), sampleRate, fftOrder);
+            juce::FloatVectorOperations::addWithMultiply (frame.data(), column.data(), level * amplitude, numBins);
         }
-
-        sineFifo.erase (sineFifo.begin(), sineFifo.begin() + hopSize);
     }
-}
 
-void TelevisionAudioProcessor::getLatestSpectrum (std::vector<float>& outSlice)
-{
-    std::scoped_lock lk (magLock);
-    outSlice = latestMagnitudes;
-}
+    FastDecibels::fromMagnitude (frame.data(), frame.data(), numBins, levelOffsetDb, levelFloorDb);
 
-void TelevisionAudioProcessor::getLatestSineSpectrum (std::vector<float>& outSlice)
-{
-    std::scoped_lock lk (sineLock);
-    outSlice = latestSineMagnitudes;
+    latestSineLevels.publish();
 }
 
 juce::AudioProcessorEditor* TelevisionAudioProcessor::createEditor()
@@ -1,9 +1,20 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <array>
 #include <vector>
-#include <deque>
-#include <mutex>
+#include "SampleRing.h"
+#include "TripleBuffer.h"
+#include "FrameQueue.h"
+#include "AnalysisThread.h"
+#include "AllocationTrap.h"
+#include "SpectrogramEngine.h"
+#include "TestToneBank.h"
+#include "ToneSpectrumCache.h"
+#include "ParallelForPool.h"
+#include "LevelQuantiser.h"
+#include "ColumnFolder.h"
+#include "HistoryStore.h"
 
 class TelevisionAudioProcessor : public juce::AudioProcessor
 {
@@ -44,16 +55,28 @@ public:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
     // ===== Visual config exposed to editor =====
-    static constexpr int fftOrder = 10;                // 2^10 = 1024
-    static constexpr int fftSize  = 1 << fftOrder;     // 1024
-    static constexpr int hopSize  = fftSize / 4;       // 256 (25% hop)
-    static constexpr int numBins  = fftSize / 2;       // 512
-    static constexpr int timeCols = 300;               // spectrogram width (pixels/columns)
-
-    int   getNumBins()   const noexcept { return numBins; }
-    int   getTimeBins()  const noexcept { return timeCols; }
+    static constexpr int minFftOrder     = 8;                  // 256
+    static constexpr int maxFftOrder     = 15;                 // 32768
+    static constexpr int defaultFftOrder = 10;                 // 1024
+    static constexpr int maxFftSize      = 1 << maxFftOrder;
+    static constexpr int maxNumBins      = maxFftSize / 2;
+    static constexpr int frameQueueDepth  = 256;               // max hops buffered for the editor
+    static constexpr int frameArenaBytes  = 1 << 23;           // 8 MB of queued spectra
+    static constexpr int maxChannels      = 16;                // analysed input channels
+    static constexpr int speedSteps       = 6;                 // each "speed" step halves the rate
+    static constexpr int maxHopsPerColumn = 1 << speedSteps;   // "speed" at 0: 64 hops per column
+    static constexpr size_t defaultHistoryBytes = 64u << 20;   // long history cap, see HistoryStore
+    static constexpr float levelFloorDb   = SpectrogramEngine<minFftOrder>::floorDb;
+    static constexpr float codeHeadroomDb = 60.0f;             // 8-bit range above 0 dB, see below
+
+    // Which spectra each analysis frame carries; also the FrameQueue layout tag of the frame.
+    // mono: one spectrum of (L+R)/2. leftRight / midSide: two spectra from one packed complex FFT.
+    // difference: left and right spectra, drawn by the editor as a level balance.
+    // allChannels: one spectrum per input channel (up to maxChannels), computed in parallel.
+    enum class ChannelView { mono = 0, leftRight, midSide, difference, allChannels };
+
     float getDynDb()     const noexcept { return 80.0f;   }
-    double getSampleRateHz() const noexcept { return currentSR; }
+    double getSampleRateHz() const noexcept { return currentSR.load(); }
 
     float getSensitivity() const
     {
@@ -65,36 +88,110 @@ public:
         return apvts.getRawParameterValue ("sineLevel")->load();
     }
 
-    // Spectrum data getters
-    void getLatestSpectrum (std::vector<float>& outSlice);
-    void getLatestSineSpectrum (std::vector<float>& outSlice);
+    int getPaletteIndex() const
+    {
+        return juce::roundToInt (apvts.getRawParameterValue ("palette")->load());
+    }
 
-private:
-    // ===== FFT & window =====
-    juce::dsp::FFT fft { fftOrder };
-    juce::dsp::WindowingFunction<float> window;
+    int getFrequencyAxisIndex() const
+    {
+        return juce::roundToInt (apvts.getRawParameterValue ("frequencyAxis")->load());
+    }
+
+    // The FFT pipeline runs on its own thread; priority and affinity apply on the next (re)start.
+    void setAnalysisThreadOptions (const AnalysisThread::Options& options);
+    const AnalysisThread::Options& getAnalysisThreadOptions() const noexcept { return analysisThread.getOptions(); }
+
+    // Reference tones mixed into the output at the "sineLevel" parameter (440 Hz by default).
+    // Safe to call from any thread; 0 Hz switches a tone off.
+    void setTestToneFrequency (int toneIndex, float hz) noexcept  { toneBank.setFrequency (toneIndex, hz); }
+
+    // How spectrum frames travel to the editor, from the "frameFormat" parameter: float dB, or
+    // 16- / 8-bit codes (a half / quarter of the bandwidth). Applies from the next analysed hop.
+    FrameQueue::Format getFrameFormat() const noexcept
+    {
+        return (FrameQueue::Format) juce::jlimit (0, 2, juce::roundToInt (frameFormatParam->load()));
+    }
+
+    // Range covered by the codes of a quantised format. 8-bit spans the displayed getDynDb()
+    // range below 0 dB plus codeHeadroomDb above it (~0.55 dB steps): the picture saturates at
+    // 0 dB, but loud bins (a full-scale sine reads about +54 dB) keep their level for the
+    // difference view's balance and the history's mean. 16-bit spans everything from the level
+    // floor up, for high-dynamic-range use.
+    LevelQuantiser getLevelQuantiser (FrameQueue::Format format) const noexcept
+    {
+        return format == FrameQueue::Format::uint8 ? LevelQuantiser { -getDynDb(), codeHeadroomDb }
+                                                   : LevelQuantiser { levelFloorDb, 80.0f };
+    }
+
+    // Spectrum data (one reader thread: the editor's compositor), in dB and never below
+    // levelFloorDb. Each frame is one screen column, folded from "speed"-dependent hops; every
+    // column is queued so the editor can draw all of them. The sine overlay is computed
+    // analytically, so only its newest frame is kept.
+    FrameQueue& getSpectrumFrames() noexcept                    { return spectrumFrames; }
+    const std::vector<float>& getLatestSineSpectrum() noexcept  { return latestSineLevels.read(); }
 
-    // ===== Audio accumulation =====
-    std::deque<float> monoFifo;
-    int samplesSinceLastFFT = 0;
-    double currentSR = 44100.0;
+    // Every analysis hop since the FFT size, overlap or channel view last changed, as 8-bit codes
+    // of getLevelQuantiser (uint8), zoomable out to hours. The display speed doesn't touch it:
+    // a screen column spans getHopsPerColumn() of its columns. Readable from any thread; its
+    // setMemoryLimit() restarts it under a new cap.
+    HistoryStore& getHistory() noexcept                         { return history; }
+    int getHopsPerColumn() const noexcept                       { return hopsPerColumn.load(); }
+
+private:
+    // ===== FFT engine (analysis thread only; rebuilt when fftSize / overlap change) =====
+    int fftOrder = 0, fftSize = 0, hopSize = 0, numBins = 0;
+    float levelOffsetDb = 0.0f;
+    ChannelView channelView = ChannelView::mono;
+    std::vector<std::unique_ptr<AnySpectrogramEngine>> engines;    // one per analysed channel
+    ParallelForPool channelPool;
+
+    std::atomic<float>* fftSizeParam = nullptr;
+    std::atomic<float>* overlapParam = nullptr;
+    std::atomic<float>* channelViewParam = nullptr;
+    std::atomic<float>* speedParam = nullptr;
+    std::atomic<float>* speedReductionParam = nullptr;
+    std::atomic<float>* frameFormatParam = nullptr;
+
+    // ===== Audio accumulation (one ring per input channel; a mono input also feeds ring 1) =====
+    std::array<SampleRing, maxChannels> inputFifos;
+    int numInputChannels = 2;
+    std::atomic<double> currentSR { 44100.0 };      // set in prepareToPlay, read by the editor too
 
     // ===== Output to UI =====
-    std::vector<float> latestMagnitudes;
-    std::mutex         magLock;
+    FrameQueue spectrumFrames;
+    FrameQueue::Format frameFormat = FrameQueue::Format::uint8;     // analysis thread's copy
+    LevelQuantiser frameQuantiser;
+    std::vector<float> stereoLevels;                // analysis-thread scratch, two spectra
+    ColumnFolder columnFolder;                      // hops -> screen columns, analysis thread only
+    std::atomic<int> hopsPerColumn { 1 };           // columnFolder's setting, a power of two
+    HistoryStore history { defaultHistoryBytes };
+    LevelQuantiser historyQuantiser;
+    std::vector<uint8_t> historyCodes;              // analysis-thread scratch, one column
 
     // ===== Sine generation =====
-    double phase = 0.0;
-    std::deque<float> sineFifo;
-    std::vector<float> latestSineMagnitudes;
-    std::mutex sineLock;
+    static constexpr float sineLevelScale = 0.2f;   // "sineLevel" 1.0 -> -14 dBFS
+
+    TestToneBank toneBank;
+    std::vector<float> sineBuffer;              // audio-thread scratch, one announced block
+    ToneSpectrumCache toneSpectra;              // analysis thread only
+    TripleBuffer<std::vector<float>> latestSineLevels;
 
     // Helpers
-    void pushAudioToFifo (const float* left, const float* rightOrNull, int numSamples);
+    void prepareBuffers (int samplesPerBlockExpected);
+    void pushAudioToFifos (const juce::AudioBuffer<float>& buffer);
     void runFFTIfReady();
+    void writeLevels (void* frame, int offset, const float* levels, int num) noexcept;
+    void addHopLevels (int offset, const float* levels, int num);
+    void endHop (int bins, int numChannels);
+
+    void updateToneSpectrum();
+
+    void updateAnalysisSetup();
+    int  runAnalysisPass();
 
-    void pushSineToFifo (const float* samples, int numSamples);
-    void runSineFFTIfReady();
+    // ===== Analysis worker (declared last so it stops before the buffers it reads go away) =====
+    AnalysisThread analysisThread { [this] { return runAnalysisPass(); } };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TelevisionAudioProcessor)
 };
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <cstring>
+
+// Fixed-capacity single-producer / single-consumer sample ring.
+// Capacity is rounded up to a power of two in prepare() so positions wrap with a mask;
+// push / read / discard never allocate and never block.
+class SampleRing
+{
+public:
+    SampleRing() = default;
+
+    // Not real-time safe: (re)allocates storage. Call from prepareToPlay only.
+    void prepare (int minCapacity)
+    {
+        capacity = juce::nextPowerOfTwo (juce::jmax (minCapacity, 2));
+        mask     = (uint64_t) capacity - 1;
+
+        storage.calloc ((size_t) capacity + alignFloats);
+        data = juce::snapPointerToAlignment (storage.get(), (size_t) cacheLine);
+
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        writePos.store (0, std::memory_order_relaxed);
+        readPos.store  (0, std::memory_order_relaxed);
+    }
+
+    // Consumer side: samples written but not yet discarded.
+    int getNumReady() const noexcept
+    {
+        return (int) (writePos.load (std::memory_order_acquire) - readPos.load (std::memory_order_relaxed));
+    }
+
+    // Producer side: samples that can be pushed without overwriting unread data.
+    int getFreeSpace() const noexcept
+    {
+        return capacity - (int) (writePos.load (std::memory_order_relaxed) - readPos.load (std::memory_order_acquire));
+    }
+
+    int push (const float* src, int numSamples) noexcept
+    {
+        const auto w   = writePos.load (std::memory_order_relaxed);
+        const int  num = juce::jmin (numSamples, getFreeSpace());
+        const int  start = (int) (w & mask);
+        const int  first = juce::jmin (num, capacity - start);
+
+        std::memcpy (data + start, src, sizeof (float) * (size_t) first);
+        std::memcpy (data, src + first, sizeof (float) * (size_t) (num - first));
+
+        writePos.store (w + (uint64_t) num, std::memory_order_release);
+        return num;
+    }
+
+    // Consumer: copies numSamples starting offset samples past the read position, without
+    // consuming them.
+    bool peek (float* dest, int numSamples, int offset = 0) const noexcept
+    {
+        if (getNumReady() < offset + numSamples)
+            return false;
+
+        const int start = (int) ((readPos.load (std::memory_order_relaxed) + (uint64_t) offset) & mask);
+        const int first = juce::jmin (numSamples, capacity - start);
+
+        std::memcpy (dest, data + start, sizeof (float) * (size_t) first);
+        std::memcpy (dest + first, data, sizeof (float) * (size_t) (numSamples - first));
+        return true;
+    }
+
+    // Consumer: releases numSamples back to the producer.
+    void discard (int numSamples) noexcept
+    {
+        jassert (numSamples <= getNumReady());
+        readPos.store (readPos.load (std::memory_order_relaxed) + (uint64_t) numSamples,
+                       std::memory_order_release);
+    }
+
+private:
+    static constexpr int cacheLine   = 64;
+    static constexpr int alignFloats = cacheLine / (int) sizeof (float);
+
+    // Producer and consumer indices live on separate cache lines to avoid false sharing.
+    alignas (cacheLine) std::atomic<uint64_t> writePos { 0 };
+    alignas (cacheLine) std::atomic<uint64_t> readPos  { 0 };
+
+    alignas (cacheLine) juce::HeapBlock<float> storage;
+    float*   data     = nullptr;
+    int      capacity = 0;
+    uint64_t mask     = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (SampleRing)
+};
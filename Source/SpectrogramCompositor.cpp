@@ -0,0 +1,499 @@
+#include "SpectrogramCompositor.h"
+#include <cmath>
+#include <cstring>
+
+SpectrogramCompositor::SpectrogramCompositor (TelevisionAudioProcessor& p)
+    : juce::Thread ("Spectrogram Compositor"),
+      audio (p),
+      requestedView (packView ({}))
+{
+    pictures.initialise ([] (Picture& picture) { picture = {}; });
+    startThread();
+}
+
+SpectrogramCompositor::~SpectrogramCompositor()
+{
+    stopThread (2000);
+    cancelHistoryRender();
+}
+
+void SpectrogramCompositor::setViewSize (int physicalWidth, int physicalHeight) noexcept
+{
+    requestedSize.store ((uint64_t) (uint32_t) juce::jmax (0, physicalWidth) << 32
+                           | (uint64_t) (uint32_t) juce::jmax (0, physicalHeight));
+    notify();
+}
+
+void SpectrogramCompositor::setHistoryView (const HistoryView& newView) noexcept
+{
+    requestedView.store (packView (newView));
+    notify();
+}
+
+void SpectrogramCompositor::resume() noexcept
+{
+    resumeRequested.store (true);
+    notify();
+}
+
+// Sleeps until asked for a frame, so a hidden or minimised editor costs nothing here either
+void SpectrogramCompositor::run()
+{
+    while (! threadShouldExit())
+    {
+        if (updateCanvas())
+            publishCanvas();
+
+        wait (-1);
+    }
+}
+
+void SpectrogramCompositor::applyViewRequest() noexcept
+{
+    const uint64_t requested = requestedView.load();
+    if (requested == packView (view))
+        return;
+
+    view = unpackView (requested);
+    historyViewDirty = true;
+}
+
+const float* SpectrogramCompositor::decodeLevels (const void* frame, const FrameQueue::FrameInfo& info)
+{
+    if (info.format == FrameQueue::Format::float32)
+        return static_cast<const float*> (frame);
+
+    const int num = info.numBins * info.numChannels;
+    decodedLevels.resize ((size_t) num);
+    const auto quantiser = audio.getLevelQuantiser (info.format);
+
+    if (info.format == FrameQueue::Format::uint8)
+        quantiser.decode (static_cast<const uint8_t*> (frame), decodedLevels.data(), num);
+    else
+        quantiser.decode (static_cast<const uint16_t*> (frame), decodedLevels.data(), num);
+
+    return decodedLevels.data();
+}
+
+void SpectrogramCompositor::countDroppedFrames (const FrameQueue::FrameInfo& info) noexcept
+{
+    if (haveSequence && info.sequence > expectedSequence)
+        numFramesDropped += info.sequence - expectedSequence;
+
+    expectedSequence = info.sequence + 1;
+    haveSequence = true;
+}
+
+// Nobody drained the queue while paused, so it filled and the producer skipped sequence numbers
+// for reasons that say nothing about keeping up. Counting restarts with the next frame queued.
+void SpectrogramCompositor::discardStaleFrames()
+{
+    auto& frames = audio.getSpectrumFrames();
+    for (int n = frames.getNumReady(); n > 0; --n)
+        frames.pop();
+
+    haveSequence = false;
+    historyViewDirty = true;
+}
+
+// Draws every queued column, oldest first; returns true if any of them reached the canvas
+bool SpectrogramCompositor::updateCanvas()
+{
+    applyViewRequest();
+
+    if (resumeRequested.exchange (false))
+        discardStaleFrames();
+
+    const bool landed = finishHistoryRender();
+
+    // A redraw that just landed is caught up from the history before live frames resume
+    if (landed || ! isShowingLive() || historyViewDirty || historyRender != nullptr)
+        return updateFromHistory() || landed;
+
+    auto& frames = audio.getSpectrumFrames();
+    const int numPending = frames.getNumReady();
+    bool drawn = false;
+
+    for (int f = 0; f < numPending; ++f)
+    {
+        FrameQueue::FrameInfo info;
+        const void* frame = frames.front (info);
+
+        countDroppedFrames (info);
+
+        // Columns the last history read covered may only be queued now; it drew them
+        if (info.position > historyAppended)
+            drawn = drawColumn (decodeLevels (frame, info), { info.numBins, info.numChannels, info.layout }, true) || drawn;
+
+        frames.pop();
+    }
+
+    return drawn || landed;
+}
+
+void SpectrogramCompositor::markChanged (int column) noexcept
+{
+    changeLog[(size_t) (canvasVersion % changeLogSize)] = column;
+    ++canvasVersion;
+}
+
+// Brings the spare slot up to the canvas and hands it over. The slot was last published a
+// couple of frames ago, so usually only the few columns written since have to be copied.
+void SpectrogramCompositor::publishCanvas()
+{
+    if (canvas.isNull())
+        return;
+
+    auto& back = pictures.getWriteFrame();
+    const int w = canvas.getWidth(), h = canvas.getHeight();
+
+    bool copyAll = back.image.getWidth() != w || back.image.getHeight() != h
+                    || canvasVersion - back.version > (uint64_t) changeLogSize;
+
+    if (back.image.getWidth() != w || back.image.getHeight() != h)
+        back.image = juce::Image (juce::Image::RGB, w, h, false, juce::SoftwareImageType());
+
+    for (uint64_t v = back.version; v < canvasVersion && ! copyAll; ++v)
+        copyAll = changeLog[(size_t) (v % changeLogSize)] < 0;
+
+    {
+        const juce::Image::BitmapData src  (canvas,     juce::Image::BitmapData::readOnly);
+        juce::Image::BitmapData       dest (back.image, juce::Image::BitmapData::writeOnly);
+
+        if (copyAll)
+        {
+            for (int y = 0; y < h; ++y)
+                std::memcpy (dest.getLinePointer (y), src.getLinePointer (y), (size_t) (w * src.pixelStride));
+        }
+        else
+        {
+            for (uint64_t v = back.version; v < canvasVersion; ++v)
+            {
+                const int x = changeLog[(size_t) (v % changeLogSize)];
+
+                for (int y = 0; y < h; ++y)
+                    std::memcpy (dest.getPixelPointer (x, y), src.getPixelPointer (x, y), (size_t) src.pixelStride);
+            }
+        }
+    }
+
+    back.numLanes    = numLanes;
+    back.writeColumn = writeColumn;
+    back.version     = canvasVersion;
+    pictures.publish();
+}
+
+// Sizes the canvas to the lane tiles and brings the palette and axis tables in line with the
+// current settings. Anything that changes how columns already drawn would look marks the view
+// for a full redraw from the history. Returns false while there is no room to draw.
+bool SpectrogramCompositor::prepareView (int lanes, int numBins)
+{
+    // One image pixel per physical screen pixel: columns are drawn at their final size and
+    // paint() never has to stretch the picture
+    const auto grid = getTileGrid (lanes);
+    if (grid.tileW <= 0 || grid.tileH <= 0)
+        return false;
+
+    const auto newPalette  = (SpectrogramPalette::Palette) juce::jlimit (0, 3, audio.getPaletteIndex());
+    const auto sensitivity = audio.getSensitivity();
+    const auto axis        = (FrequencyAxisMap::Axis) juce::jlimit (0, 2, audio.getFrequencyAxisIndex());
+    const double sampleRate = audio.getSampleRateHz();
+
+    if (! palette.matches (newPalette, sensitivity, audio.getDynDb())
+         || ! axisMap.matches (axis, numBins, sampleRate, grid.tileH))
+    {
+        cancelHistoryRender();      // its workers read both tables
+
+        palette.update (newPalette, sensitivity, audio.getDynDb());
+        axisMap.update (axis, numBins, sampleRate, grid.tileH);
+        sineRowLevels.resize ((size_t) grid.tileH);
+        numSilentColumns = 0;
+        historyViewDirty = true;
+    }
+
+    if (canvas.getWidth()  != grid.tileW
+     || canvas.getHeight() != grid.tileH * lanes)
+    {
+        canvas = juce::Image (juce::Image::RGB, grid.tileW, grid.tileH * lanes, true, juce::SoftwareImageType());
+        writeColumn = 0;
+        numSilentColumns = 0;
+        historyViewDirty = true;
+        markChanged (-1);
+    }
+
+    numLanes = lanes;
+    return true;
+}
+
+// Colours one column of levels (numBins per channel, laid out as in a frame) into column x of
+// bitmap through the axis and palette tables. Only reads shared state, so history renders call
+// it from several workers at once; sineRows is the mapped overlay, or null.
+void SpectrogramCompositor::renderColumn (juce::Image::BitmapData& bitmap, int x, const float* levels,
+                                          const HistoryStore::Shape& shape, const float* sineRows,
+                                          ColumnScratch& scratch) const
+{
+    using ChannelView = TelevisionAudioProcessor::ChannelView;
+    const bool difference = shape.layout == (int) ChannelView::difference;
+
+    // Each analysed channel gets its own horizontal lane, first channel on top;
+    // the difference view folds its two channels into one lane
+    const int lanes    = difference ? 1 : shape.numChannels;
+    const int numBins  = shape.numBins;
+    const int laneRows = axisMap.getNumRows();
+
+    scratch.rows.resize ((size_t) laneRows);
+    scratch.otherRows.resize ((size_t) laneRows);
+
+    const bool rgb = bitmap.pixelFormat == juce::Image::RGB;
+
+    auto store = [&bitmap, rgb, x] (int row, juce::PixelARGB pixel)
+    {
+        auto* dest = bitmap.getPixelPointer (x, row);
+
+        if (rgb)
+            reinterpret_cast<juce::PixelRGB*> (dest)->set (pixel);
+        else
+            reinterpret_cast<juce::PixelARGB*> (dest)->set (pixel);
+    };
+
+    for (int lane = 0; lane < lanes; ++lane)
+    {
+        // Left / right level balance for the difference view, otherwise the pink/white spectrum
+        const float* slice = levels + lane * numBins;
+        const int laneBottom = (lane + 1) * laneRows - 1;
+
+        axisMap.apply (slice, scratch.rows.data());
+        if (difference)
+            axisMap.apply (slice + numBins, scratch.otherRows.data());
+
+        for (int y = 0; y < laneRows; ++y)
+        {
+            if (sineRows != nullptr && sineRows[y] > -60.0f)
+                store (laneBottom - y, palette.sine (sineRows[y]));
+            else if (difference)
+                store (laneBottom - y, palette.balance (scratch.rows[(size_t) y], scratch.otherRows[(size_t) y]));
+            else
+                store (laneBottom - y, palette.level (scratch.rows[(size_t) y]));
+        }
+    }
+}
+
+// Appends one column to the circular canvas. Only live columns carry the sine overlay: the
+// history has no record of what it showed when older columns were analysed.
+bool SpectrogramCompositor::drawColumn (const float* levels, const HistoryStore::Shape& shape, bool live)
+{
+    using ChannelView = TelevisionAudioProcessor::ChannelView;
+    if (! prepareView (shape.layout == (int) ChannelView::difference ? 1 : shape.numChannels, shape.numBins))
+        return false;
+
+    const int w = canvas.getWidth();
+    const float dynDb = audio.getDynDb();
+
+    const auto& sineSlice = audio.getLatestSineSpectrum();
+    const bool  hasSine   = live && (int) sineSlice.size() >= shape.numBins;
+
+    // Once a full screen of silence has been drawn, further silent columns change nothing:
+    // keep draining frames but stop writing and publishing until something is audible again
+    const bool silent = juce::FloatVectorOperations::findMaximum (levels, shape.getNumValues()) <= -dynDb
+                     && (! hasSine || juce::FloatVectorOperations::findMaximum (sineSlice.data(), shape.numBins) <= -60.0f);
+
+    numSilentColumns = silent ? juce::jmin (numSilentColumns + 1, w + 1) : 0;
+    if (numSilentColumns > w)
+        return false;
+
+    // The canvas is circular: overwrite the oldest column in place rather than scrolling
+    const int x = writeColumn;
+    writeColumn = (writeColumn + 1) % w;
+
+    if (hasSine)
+        axisMap.apply (sineSlice.data(), sineRowLevels.data());
+
+    juce::Image::BitmapData bitmap (canvas, x, 0, 1, canvas.getHeight(), juce::Image::BitmapData::writeOnly);
+    renderColumn (bitmap, 0, levels, shape, hasSine ? sineRowLevels.data() : nullptr, liveScratch);
+    markChanged (x);
+    return true;
+}
+
+// Zoomed out or scrolled back. The history holds one column per analysis hop; each pixel column
+// folds 2^zoom screen columns of getHopsPerColumn() hops, on a grid aligned to that step so every
+// read covers whole pyramid columns. Queued frames the history already covers are only dropped
+// here; the count is read first, so a frame queued after it stays queued and is never also drawn
+// live. Following live, each newly completed pixel column is appended to the circular canvas;
+// anything else (zoom, scroll, speed, resize, palette, axis, a new FFT shape) redraws the view
+// from the history on the render pool, one folded column read per pixel column.
+bool SpectrogramCompositor::updateFromHistory()
+{
+    HistoryStore::Shape shape;
+    uint64_t numAppended = 0;
+    const uint64_t numColumns = audio.getHistory().getNumColumns (shape, numAppended);
+
+    const uint64_t step = (uint64_t) audio.getHopsPerColumn() << view.zoom;
+    const uint64_t end  = (view.followLive ? numColumns : juce::jmin (view.end, numColumns)) / step * step;
+
+    // Following live, a frame whose column straddles end stays queued, to be drawn live should
+    // the view return there; browsing, everything the history holds is dropped
+    historyAppended = numAppended - (view.followLive ? numColumns - end : 0);
+
+    auto& frames = audio.getSpectrumFrames();
+    for (int n = frames.getNumReady(); n > 0; --n)
+    {
+        FrameQueue::FrameInfo info;
+        frames.front (info);
+
+        if (info.position > historyAppended)
+            break;
+
+        countDroppedFrames (info);
+        frames.pop();
+    }
+
+    if (shape.getNumValues() <= 0)
+        return false;
+
+    using ChannelView = TelevisionAudioProcessor::ChannelView;
+    if (! prepareView (shape.layout == (int) ChannelView::difference ? 1 : shape.numChannels, shape.numBins))
+        return false;
+
+    const int w = canvas.getWidth();
+
+    if (historyViewDirty || shape != renderedShape || (int64_t) step != renderedStep || end < renderedEnd
+         || (end - renderedEnd) / step >= (uint64_t) w)
+    {
+        startHistoryRender (shape, end, (int64_t) step);
+        return false;
+    }
+
+    // Columns that complete while a redraw is running are appended once it has landed
+    if (historyRender != nullptr || end == renderedEnd)
+        return false;
+
+    for (int64_t first = (int64_t) renderedEnd; first < (int64_t) end; first += (int64_t) step)
+        drawHistoryColumn (first, first + (int64_t) step, shape);
+
+    renderedEnd = end;
+    return true;
+}
+
+// Columns before the start of the history, or no longer retained, are drawn as silence
+void SpectrogramCompositor::drawHistoryColumn (int64_t first, int64_t last, const HistoryStore::Shape& shape)
+{
+    historyCodes.resize ((size_t) shape.getNumValues());
+
+    if (first < 0 || ! audio.getHistory().read ((uint64_t) first, (uint64_t) last, historyCodes.data(), shape))
+        std::fill (historyCodes.begin(), historyCodes.end(), (uint8_t) 0);
+
+    FrameQueue::FrameInfo info;
+    info.numBins     = shape.numBins;
+    info.numChannels = shape.numChannels;
+    info.format      = FrameQueue::Format::uint8;
+
+    drawColumn (decodeLevels (historyCodes.data(), info), shape, false);
+}
+
+// Redraws the whole view from the history into a fresh image, split into column tiles on the
+// render pool. The canvas keeps its picture until every tile is done; a later change cancels
+// the redraw rather than queueing behind it. The last tile wakes the worker to swap it in.
+void SpectrogramCompositor::startHistoryRender (const HistoryStore::Shape& shape, uint64_t end, int64_t step)
+{
+    cancelHistoryRender();
+
+    auto render = std::make_shared<HistoryRender>();
+    render->image  = juce::Image (juce::Image::RGB, canvas.getWidth(), canvas.getHeight(),
+                                  true, juce::SoftwareImageType());
+    render->pixels = std::make_unique<juce::Image::BitmapData> (render->image, juce::Image::BitmapData::writeOnly);
+    render->shape  = shape;
+    render->end    = end;
+    render->step   = step;
+
+    const int w = render->image.getWidth();
+    const int numTiles = (w + renderTileColumns - 1) / renderTileColumns;
+    render->tilesRemaining = numTiles;
+
+    for (int t = 0; t < numTiles; ++t)
+    {
+        renderPool.addJob ([this, render, t, w]
+        {
+            renderHistoryTile (*render, t * renderTileColumns, juce::jmin (w, (t + 1) * renderTileColumns));
+
+            if (--render->tilesRemaining == 0)
+                notify();
+        });
+    }
+
+    historyRender = render;
+    historyViewDirty = false;
+    renderedEnd = end;
+    renderedStep = step;
+    renderedShape = shape;
+}
+
+// Render pool: columns [x0, x1) of a history redraw
+void SpectrogramCompositor::renderHistoryTile (HistoryRender& render, int x0, int x1) const
+{
+    const int numValues = render.shape.getNumValues();
+    const int w = render.image.getWidth();
+    const auto quantiser = audio.getLevelQuantiser (FrameQueue::Format::uint8);
+
+    ColumnScratch scratch;
+    std::vector<uint8_t> codes ((size_t) numValues);
+    std::vector<float> levels ((size_t) numValues);
+
+    for (int x = x0; x < x1; ++x)
+    {
+        if (render.cancelled.load())
+            return;
+
+        const int64_t first = (int64_t) render.end - (int64_t) (w - x) * render.step;
+
+        if (first < 0 || ! audio.getHistory().read ((uint64_t) first, (uint64_t) (first + render.step), codes.data(), render.shape))
+            std::fill (codes.begin(), codes.end(), (uint8_t) 0);
+
+        quantiser.decode (codes.data(), levels.data(), numValues);
+        renderColumn (*render.pixels, x, levels.data(), render.shape, nullptr, scratch);
+    }
+}
+
+// Makes a finished redraw the canvas. Returns true if one landed.
+bool SpectrogramCompositor::finishHistoryRender()
+{
+    if (historyRender == nullptr || historyRender->tilesRemaining.load() > 0)
+        return false;
+
+    historyRender->pixels.reset();
+    canvas = historyRender->image;
+    historyRender = nullptr;
+    writeColumn = 0;
+    numSilentColumns = 0;
+    markChanged (-1);
+    return true;
+}
+
+// Stops a running redraw and waits for workers still inside a column, so the tables they read
+// can be rebuilt straight after.
+void SpectrogramCompositor::cancelHistoryRender()
+{
+    if (historyRender == nullptr)
+        return;
+
+    historyRender->cancelled = true;
+    historyRender = nullptr;
+    renderPool.removeAllJobs (true, 1000);
+}
+
+int SpectrogramCompositor::getGridColumns (int lanes) noexcept
+{
+    return lanes <= 2 ? 1 : (int) std::ceil (std::sqrt ((double) lanes));
+}
+
+// Lanes split the spectrum area into equal tiles, measured in physical pixels
+SpectrogramCompositor::TileGrid SpectrogramCompositor::getTileGrid (int lanes) const noexcept
+{
+    const uint64_t size = requestedSize.load();
+
+    TileGrid grid;
+    grid.cols  = getGridColumns (lanes);
+    grid.rows  = (lanes + grid.cols - 1) / grid.cols;
+    grid.tileW = (int) (size >> 32) / grid.cols;
+    grid.tileH = (int) (size & 0xffffffffu) / grid.rows;
+    return grid;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "PluginProcessor.h"
+#include "SpectrogramPalette.h"
+#include "FrequencyAxisMap.h"
+#include "TripleBuffer.h"
+
+// Composes the spectrogram picture away from the message thread. A worker decodes queued frames
+// (or reads the history), maps and colours them into its own canvas, then copies just the columns
+// that changed into the spare slot of a triple buffer and publishes it. The editor takes the
+// newest published picture once per display refresh without locking or waiting, and paint()
+// blits it, so its cost is one blit whatever arrived; the worker never touches the picture on
+// screen. It sleeps until the editor asks for a frame.
+class SpectrogramCompositor : private juce::Thread
+{
+public:
+    // One lane tile per channel at its on-screen size in physical pixels, lanes stacked top-down
+    struct Picture
+    {
+        juce::Image image;
+        int numLanes = 1;
+        int writeColumn = 0;        // circular: the next column to write, i.e. the oldest one shown
+        uint64_t version = 0;       // canvas version the image was last brought up to
+    };
+
+    explicit SpectrogramCompositor (TelevisionAudioProcessor&);
+    ~SpectrogramCompositor() override;
+
+    // ===== Message thread =====
+    // Size of the whole spectrum area in physical pixels
+    void setViewSize (int physicalWidth, int physicalHeight) noexcept;
+
+    // Live at zoom 0 while following draws queued frames as they come; anything else is drawn
+    // from the processor's HistoryStore. The default is live.
+    struct HistoryView
+    {
+        int zoom = 0;                   // one pixel column per 2^zoom screen columns
+        bool followLive = true;         // right edge tracks the newest column
+        uint64_t end = 0;               // right edge while browsing: exclusive, in history
+                                        // columns, rounded down to a pixel column's step
+    };
+
+    void setHistoryView (const HistoryView&) noexcept;
+    HistoryView getHistoryView() const noexcept     { return unpackView (requestedView.load()); }
+
+    // Wakes the worker to pick up new frames or view changes; call once per display refresh
+    void requestFrame() const                   { notify(); }
+
+    // Call when drawing resumes after a pause (e.g. the window was minimised). Frames queued
+    // meanwhile are thrown away rather than counted as dropped, and the view is redrawn from
+    // the history. Construction does the same for frames queued before the editor opened.
+    void resume() noexcept;
+
+    bool hasNewPicture() const noexcept         { return pictures.hasNewFrame(); }
+
+    // The newest published picture; stays valid and untouched until the next call
+    const Picture& getPicture() noexcept        { return pictures.read(); }
+
+    // Screen columns that never arrived because the frame queue overflowed
+    uint64_t getNumFramesDropped() const noexcept { return numFramesDropped.load(); }
+
+    // One or two lanes share the area top / bottom; more (surround, ambisonics) are laid out as
+    // a near-square grid of tiles, this many per row, in channel order
+    static int getGridColumns (int lanes) noexcept;
+
+private:
+    TelevisionAudioProcessor& audio;
+
+    std::atomic<uint64_t> requestedSize { 0 };              // width << 32 | height
+    std::atomic<uint64_t> requestedView;                     // see packView()
+    std::atomic<uint64_t> numFramesDropped { 0 };
+    std::atomic<bool> resumeRequested { true };
+
+    TripleBuffer<Picture> pictures;
+
+    // ===== Worker thread only =====
+    std::vector<float> decodedLevels;       // a quantised frame expanded back to dB
+    uint64_t expectedSequence = 0;
+    bool     haveSequence = false;
+
+    // The picture being composed, drawn exactly as the published ones will look
+    juce::Image canvas;
+    int numLanes = 1;
+    int writeColumn = 0;
+    int numSilentColumns = 0;   // consecutive columns with nothing above the palette floor
+    SpectrogramPalette palette;
+    FrequencyAxisMap axisMap;
+    std::vector<float> sineRowLevels;       // overlay mapped to one lane, bottom row first
+
+    // Canvas column written by each change, or -1 for all of them, so a published slot that has
+    // fallen behind is caught up column by column rather than copied whole
+    static constexpr int changeLogSize = 4096;
+    std::array<int, changeLogSize> changeLog {};
+    uint64_t canvasVersion = 0;
+
+    struct ColumnScratch
+    {
+        std::vector<float> rows, otherRows;     // one lane's column, bottom row first
+    };
+
+    ColumnScratch liveScratch;
+
+    HistoryView view;                   // as last applied from requestedView
+    bool historyViewDirty = false;      // redraw the whole view from the history on the next frame
+    uint64_t renderedEnd = 0;
+    int64_t  renderedStep = 0;
+    uint64_t historyAppended = 0;       // history's running count where the last view of it ended
+    HistoryStore::Shape renderedShape;
+    std::vector<uint8_t> historyCodes;
+
+    // A full redraw from the history, filled tile by tile on renderPool and swapped in when done
+    struct HistoryRender
+    {
+        juce::Image image;
+        std::unique_ptr<juce::Image::BitmapData> pixels;    // released on the worker before use
+        HistoryStore::Shape shape;
+        uint64_t end = 0;
+        int64_t step = 1;
+        std::atomic<int> tilesRemaining { 0 };
+        std::atomic<bool> cancelled { false };
+    };
+
+    static constexpr int renderTileColumns = 64;
+
+    std::shared_ptr<HistoryRender> historyRender;       // the redraw in flight, if any
+    juce::ThreadPool renderPool { juce::jmax (1, juce::SystemStats::getNumCpus() - 1) };
+
+    static uint64_t packView (const HistoryView& v) noexcept
+    {
+        return v.end << 5 | (v.followLive ? 16u : 0u) | (uint64_t) (v.zoom & 15);
+    }
+
+    static HistoryView unpackView (uint64_t packed) noexcept
+    {
+        return { (int) (packed & 15), (packed & 16) != 0, packed >> 5 };
+    }
+
+    void run() override;
+    void applyViewRequest() noexcept;
+    bool updateCanvas();
+    void publishCanvas();
+    void markChanged (int column) noexcept;
+    bool prepareView (int lanes, int numBins);
+    void renderColumn (juce::Image::BitmapData& bitmap, int x, const float* levels,
+                       const HistoryStore::Shape& shape, const float* sineRows, ColumnScratch& scratch) const;
+    bool drawColumn (const float* levels, const HistoryStore::Shape& shape, bool live);
+    bool updateFromHistory();
+    void startHistoryRender (const HistoryStore::Shape& shape, uint64_t end, int64_t step);
+    void renderHistoryTile (HistoryRender& render, int x0, int x1) const;
+    bool finishHistoryRender();
+    void cancelHistoryRender();
+    void countDroppedFrames (const FrameQueue::FrameInfo& info) noexcept;
+    void discardStaleFrames();
+    void drawHistoryColumn (int64_t first, int64_t last, const HistoryStore::Shape& shape);
+    bool isShowingLive() const noexcept     { return view.followLive && view.zoom == 0; }
+    const float* decodeLevels (const void* frame, const FrameQueue::FrameInfo& info);
+
+    struct TileGrid { int cols, rows, tileW, tileH; };
+    TileGrid getTileGrid (int lanes) const noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrogramCompositor)
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+#include <memory>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "FastDecibels.h"
+#include "FFTBackendSelection.h"
+
+// Window -> FFT -> power -> dB pipeline for one fixed FFT order.
+// Sizes are compile-time constants so the per-frame loops keep constant trip counts
+// and can be unrolled / vectorised; the runtime-selected order is dispatched once per
+// batch of frames through AnySpectrogramEngine, never per frame.
+// Real FFTs go through the backend FFTBackendSelection measured fastest for this order; when
+// batchLanes hops are ready at once and it pays off, computeBatchDecibels() instead transforms
+// them together in LaneRealFFT, so every butterfly is a SIMD op across frames.
+// Levels come out in dB, taken from |X|^2 by FastDecibels and clamped at floorDb.
+template <int Order>
+class SpectrogramEngine
+{
+public:
+    static constexpr int order   = Order;
+    static constexpr int fftSize = 1 << Order;
+    static constexpr int numBins = fftSize / 2;
+
+    static constexpr int maxBatch   = 8;    // frames accepted by computeBatchDecibels()
+    static constexpr int batchLanes = 4;    // frames transformed side by side
+
+    static constexpr float floorDb = -160.0f;   // silence and anything quieter
+
+    SpectrogramEngine()
+        : fft (Order), window ((size_t) fftSize), scratch ((size_t) fftSize * 2),
+          secondInput ((size_t) fftSize), packed ((size_t) fftSize), spectrum ((size_t) fftSize),
+          batchInput ((size_t) (maxBatch * fftSize)), batchDecibels ((size_t) (maxBatch * numBins))
+    {
+        juce::dsp::WindowingFunction<float>::fillWindowingTables (window.data(), (size_t) fftSize,
+                                                                 juce::dsp::WindowingFunction<float>::hann, true);
+
+        const auto choice = FFTBackendSelection::getInstance().getChoice<Order>();
+        backend = createFFTBackend<Order> (choice.backend);
+        useLaneBatches = choice.useLaneBatches;
+    }
+
+    // Where the caller writes the next fftSize input samples before calling computeDecibels()
+    // (or the left channel, before computeStereoDecibels()).
+    float* getInputBuffer() noexcept            { return scratch.data(); }
+
+    // Right channel input for computeStereoDecibels().
+    float* getSecondInputBuffer() noexcept      { return secondInput.data(); }
+
+    // Windows the input buffer in place, transforms it and writes numBins levels in dB,
+    // 20 log10 |X[k]| + offsetDb.
+    void computeDecibels (float* decibelsOut, float offsetDb) noexcept
+    {
+        float* data = scratch.data();
+        const float* win = window.data();
+
+        for (int i = 0; i < fftSize; ++i)
+            data[i] *= win[i];
+
+        backend->performPower (data, decibelsOut);
+        FastDecibels::fromPower (decibelsOut, decibelsOut, numBins, offsetDb, floorDb);
+    }
+
+    // Both channels in one complex FFT: z = wL + j wR, then by conjugate symmetry
+    //   L[k] = (Z[k] + Z*[N-k]) / 2,   R[k] = (Z[k] - Z*[N-k]) / 2j
+    // Writes the levels of L and R, or of (L+R)/2 and (L-R)/2 when midSide is set, in dB.
+    void computeStereoDecibels (float* firstOut, float* secondOut, bool midSide, float offsetDb) noexcept
+    {
+        const float* left  = scratch.data();
+        const float* right = secondInput.data();
+        const float* win   = window.data();
+
+        for (int i = 0; i < fftSize; ++i)
+            packed[(size_t) i] = { left[i] * win[i], right[i] * win[i] };
+
+        fft.perform (packed.data(), spectrum.data(), false);
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            const auto z  = spectrum[(size_t) k];
+            const auto zc = std::conj (spectrum[(size_t) ((fftSize - k) & (fftSize - 1))]);
+
+            const auto l = z + zc;                                  // 2 L[k]
+            const auto r = Complex ((z - zc).imag(), -(z - zc).real());   // 2 R[k] = (z - zc) / j
+
+            if (midSide)
+            {
+                firstOut[k]  = std::norm (l + r) * 0.0625f;
+                secondOut[k] = std::norm (l - r) * 0.0625f;
+            }
+            else
+            {
+                firstOut[k]  = std::norm (l) * 0.25f;
+                secondOut[k] = std::norm (r) * 0.25f;
+            }
+        }
+
+        FastDecibels::fromPower (firstOut,  firstOut,  numBins, offsetDb, floorDb);
+        FastDecibels::fromPower (secondOut, secondOut, numBins, offsetDb, floorDb);
+    }
+
+    // ===== Batched frames =====
+    // Where the caller writes frame f (fftSize samples) before calling computeBatchDecibels().
+    float* getBatchInputBuffer (int frame) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (frame, maxBatch));
+        return batchInput.data() + (size_t) frame * fftSize;
+    }
+
+    // Windows and transforms the first numFrames batch inputs. Results match computeDecibels()
+    // and are read back with getBatchDecibels().
+    void computeBatchDecibels (int numFrames, float offsetDb) noexcept
+    {
+        jassert (numFrames <= maxBatch);
+
+        const int lanes = useLaneBatches ? batchLanes : 1;
+
+        for (int first = 0; first < numFrames; first += lanes)
+        {
+            const int count = juce::jmin (lanes, numFrames - first);
+
+            if (count < batchLanes)
+            {
+                // Empty lanes cost as much as full ones, so a partial batch loses to the selected
+                // backend; the leftover frames go through it one at a time
+                for (int f = first; f < first + count; ++f)
+                {
+                    std::copy (getBatchInputBuffer (f), getBatchInputBuffer (f) + fftSize, scratch.data());
+                    computeDecibels (batchDecibels.data() + (size_t) f * numBins, offsetDb);
+                }
+            }
+            else
+            {
+                const float* frames[batchLanes];
+                float* outs[batchLanes];
+
+                for (int l = 0; l < count; ++l)
+                {
+                    frames[l] = getBatchInputBuffer (first + l);
+                    outs[l]   = batchDecibels.data() + (size_t) (first + l) * numBins;
+                }
+
+                laneFFT.performPower (frames, count, window.data(), outs);
+                FastDecibels::fromPower (outs[0], outs[0], count * numBins, offsetDb, floorDb);
+            }
+        }
+    }
+
+    const float* getBatchDecibels (int frame) const noexcept
+    {
+        return batchDecibels.data() + (size_t) frame * numBins;
+    }
+
+private:
+    using Complex = juce::dsp::Complex<float>;
+
+    juce::dsp::FFT fft;             // complex, for the packed stereo path
+    std::vector<float> window;
+    std::vector<float> scratch;     // 2 * fftSize, as the JUCE FFT requires
+    std::vector<float> secondInput;
+    std::vector<Complex> packed, spectrum;
+
+    std::vector<float> batchInput, batchDecibels;
+
+    std::unique_ptr<FFTBackend> backend;            // real FFTs, one frame at a time
+    LaneRealFFT<Order, batchLanes> laneFFT;         // real FFTs, batchLanes frames at a time
+    bool useLaneBatches = false;
+
+    JUCE_DECLARE_NON_COPYABLE (SpectrogramEngine)
+};
+
+//==============================================================================
+namespace SpectrogramEngineDetail
+{
+    constexpr int minOrder = 8;
+    constexpr int maxOrder = 15;
+
+    template <typename Seq> struct VariantOf;
+
+    template <int... Offsets>
+    struct VariantOf<std::integer_sequence<int, Offsets...>>
+    {
+        using Type = std::variant<SpectrogramEngine<minOrder + Offsets>...>;
+
+        static std::unique_ptr<Type> create (int order)
+        {
+            using Factory = std::unique_ptr<Type> (*)();
+            static constexpr Factory factories[] =
+            {
+                [] { return std::make_unique<Type> (std::in_place_type<SpectrogramEngine<minOrder + Offsets>>); }...
+            };
+
+            return factories[order - minOrder]();
+        }
+    };
+
+    using Engines = VariantOf<std::make_integer_sequence<int, maxOrder - minOrder + 1>>;
+}
+
+// One engine per supported order (256 .. 32768 points). Use std::visit to get the typed engine.
+using AnySpectrogramEngine = SpectrogramEngineDetail::Engines::Type;
+
+inline std::unique_ptr<AnySpectrogramEngine> createSpectrogramEngine (int order)
+{
+    jassert (order >= SpectrogramEngineDetail::minOrder && order <= SpectrogramEngineDetail::maxOrder);
+    return SpectrogramEngineDetail::Engines::create (juce::jlimit (SpectrogramEngineDetail::minOrder,
+                                                                   SpectrogramEngineDetail::maxOrder, order));
+}
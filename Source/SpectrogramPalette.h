@@ -0,0 +1,139 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+
+// Precomputed level -> pixel tables for the spectrogram.
+// Rebuilt on the compositor thread only when palette, sensitivity or dynamic range change; after
+// that, colouring a bin is an index computation and one load. Levels are in dB, with
+// [-dynDb, 0] spread over levelSteps entries.
+class SpectrogramPalette
+{
+public:
+    enum class Palette { whitePink = 0, viridis, magma, greyscale };
+
+    static constexpr int levelSteps     = 4096;     // ~0.02 dB apart over an 80 dB range
+    static constexpr int balanceLevels  = 256;      // difference view: level x balance table
+    static constexpr int balanceSteps   = 49;       // -24 .. +24 dB left/right, 1 dB apart
+
+    bool matches (Palette otherPalette, float otherSensitivity, float otherDynDb) const noexcept
+    {
+        return built && otherPalette == palette && otherSensitivity == sensitivity && otherDynDb == dynDb;
+    }
+
+    // Returns true if the tables were rebuilt.
+    bool update (Palette newPalette, float newSensitivity, float newDynDb)
+    {
+        if (matches (newPalette, newSensitivity, newDynDb))
+            return false;
+
+        palette = newPalette;
+        sensitivity = newSensitivity;
+        dynDb = newDynDb;
+        built = true;
+
+        levelScale   = (float) (levelSteps - 1) / dynDb;
+        balanceScale = (float) (balanceLevels - 1) / dynDb;
+
+        levelTable.resize ((size_t) levelSteps);
+        for (int i = 0; i < levelSteps; ++i)
+            levelTable[(size_t) i] = colourFor (palette, juce::jmin (1.0f, sensitivity * (float) i / (float) (levelSteps - 1)));
+
+        balanceTable.resize ((size_t) (balanceLevels * balanceSteps));
+        for (int i = 0; i < balanceLevels; ++i)
+            for (int b = 0; b < balanceSteps; ++b)
+                balanceTable[(size_t) (i * balanceSteps + b)] = balanceColour (juce::jmin (1.0f, sensitivity * (float) i / (float) (balanceLevels - 1)),
+                                                                               (float) (b - balanceSteps / 2) / (float) (balanceSteps / 2));
+
+        sineTable.resize ((size_t) balanceLevels);
+        for (int i = 0; i < balanceLevels; ++i)
+        {
+            const float t = (float) i / (float) (balanceLevels - 1);
+            sineTable[(size_t) i] = toPixel (1.0f - t, 1.0f, 1.0f - t);     // white -> green
+        }
+
+        return true;
+    }
+
+    juce::PixelARGB level (float db) const noexcept
+    {
+        return levelTable[(size_t) index (db, levelScale, levelSteps)];
+    }
+
+    // Brightness follows the louder side; hue leans pink for left, blue for right (±24 dB = full)
+    juce::PixelARGB balance (float dbLeft, float dbRight) const noexcept
+    {
+        const int i = index (juce::jmax (dbLeft, dbRight), balanceScale, balanceLevels);
+        const int b = (int) (juce::jlimit (-24.0f, 24.0f, dbLeft - dbRight) + 24.5f);
+        return balanceTable[(size_t) (i * balanceSteps + b)];
+    }
+
+    // Reference tone overlay, independent of palette and sensitivity
+    juce::PixelARGB sine (float db) const noexcept
+    {
+        return sineTable[(size_t) index (db, balanceScale, balanceLevels)];
+    }
+
+private:
+    Palette palette = Palette::whitePink;
+    float sensitivity = 1.0f, dynDb = 80.0f;
+    float levelScale = 1.0f, balanceScale = 1.0f;
+    bool built = false;
+
+    std::vector<juce::PixelARGB> levelTable, balanceTable, sineTable;
+
+    int index (float db, float scale, int steps) const noexcept
+    {
+        return (int) juce::jlimit (0.0f, (float) (steps - 1), (db + dynDb) * scale);
+    }
+
+    static juce::PixelARGB toPixel (float r, float g, float b) noexcept
+    {
+        return juce::PixelARGB (255, (juce::uint8) (r * 255.0f + 0.5f),
+                                     (juce::uint8) (g * 255.0f + 0.5f),
+                                     (juce::uint8) (b * 255.0f + 0.5f));
+    }
+
+    static float lerp (float a, float b, float u) noexcept   { return a + (b - a) * u; }
+
+    // Piecewise-linear through evenly spaced 0xRRGGBB stops
+    template <size_t N>
+    static juce::PixelARGB interpolate (const std::array<juce::uint32, N>& stops, float t) noexcept
+    {
+        const float pos = t * (float) (N - 1);
+        const int i = juce::jmin ((int) pos, (int) N - 2);
+        const float u = pos - (float) i;
+
+        auto channel = [&] (int shift, size_t s) { return (float) ((stops[s] >> shift) & 0xff) / 255.0f; };
+
+        return toPixel (lerp (channel (16, (size_t) i), channel (16, (size_t) i + 1), u),
+                        lerp (channel (8,  (size_t) i), channel (8,  (size_t) i + 1), u),
+                        lerp (channel (0,  (size_t) i), channel (0,  (size_t) i + 1), u));
+    }
+
+    static juce::PixelARGB colourFor (Palette p, float t) noexcept
+    {
+        // matplotlib's viridis and magma, sampled at ten even points
+        static constexpr std::array<juce::uint32, 10> viridis { 0x440154, 0x482878, 0x3e4a89, 0x31688e, 0x26828e,
+                                                                0x1f9e89, 0x35b779, 0x6dcd59, 0xb4de2c, 0xfde725 };
+        static constexpr std::array<juce::uint32, 10> magma   { 0x000004, 0x180f3d, 0x440f76, 0x721f81, 0x9e2f7f,
+                                                                0xcd4071, 0xf1605d, 0xfd9668, 0xfec98d, 0xfcfdbf };
+        switch (p)
+        {
+            case Palette::viridis:      return interpolate (viridis, t);
+            case Palette::magma:        return interpolate (magma, t);
+            case Palette::greyscale:    return toPixel (1.0f - t, 1.0f - t, 1.0f - t);
+            case Palette::whitePink:
+            default:                    return toPixel (1.0f, lerp (1.0f, 0.20f, t), lerp (1.0f, 0.65f, t));
+        }
+    }
+
+    static juce::PixelARGB balanceColour (float t, float bal) noexcept
+    {
+        const float r = bal >= 0.0f ? 1.0f : lerp (0.55f, 0.20f, -bal);
+        const float g = bal >= 0.0f ? lerp (0.55f, 0.20f, bal) : lerp (0.55f, 0.55f, -bal);
+        const float b = bal >= 0.0f ? lerp (0.55f, 0.65f, bal) : 1.0f;
+        return toPixel (lerp (1.0f, r, t), lerp (1.0f, g, t), lerp (1.0f, b, t));
+    }
+};
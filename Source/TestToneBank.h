@@ -0,0 +1,188 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+
+// Bank of up to maxTones sine oscillators driven by recursive complex rotation.
+// State is kept structure-of-arrays with a fixed lane count, so the per-sample update is one
+// vectorisable complex multiply across all tones instead of a std::sin per tone per sample.
+// Audible tones are packed into the first lanes and only 4 or 8 lanes run, whichever holds
+// them; a bank with no audible tone or at zero level renders nothing at all.
+// The phasors are renormalised once per block, which keeps amplitude and phase drift bounded.
+class TestToneBank
+{
+public:
+    static constexpr int maxTones = 8;
+
+    TestToneBank()
+    {
+        for (auto& f : requestedHz)
+            f.store (0.0f, std::memory_order_relaxed);
+
+        requestedHz[0].store (440.0f, std::memory_order_relaxed);
+    }
+
+    void prepare (double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        level.reset (sampleRate, 0.02);
+        level.setCurrentAndTargetValue (level.getTargetValue());
+
+        re.fill (1.0f);
+        im.fill (0.0f);
+        laneTone.fill (-1);
+        numLanes = 0;
+        appliedVersion = -1;
+    }
+
+    // Any thread. A frequency of 0 (or at/above Nyquist) switches the tone off.
+    void setFrequency (int toneIndex, float hz) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (toneIndex, maxTones));
+        requestedHz[(size_t) toneIndex].store (hz, std::memory_order_relaxed);
+        version.fetch_add (1, std::memory_order_release);
+    }
+
+    float getFrequency (int toneIndex) const noexcept   { return requestedHz[(size_t) toneIndex].load (std::memory_order_relaxed); }
+
+    // Any thread: the peak amplitude of one tone at unit level, matching what render() produces
+    // once the current frequencies have been applied.
+    float getToneAmplitude (int toneIndex, double rate) const noexcept
+    {
+        int numActive = 0;
+        for (auto& f : requestedHz)
+            numActive += isAudible (f.load (std::memory_order_relaxed), rate) ? 1 : 0;
+
+        return isAudible (getFrequency (toneIndex), rate) ? 1.0f / (float) juce::jmax (1, numActive) : 0.0f;
+    }
+
+    // Audio thread. Level changes ramp over 20 ms.
+    void setLevel (float newLevel) noexcept             { level.setTargetValue (newLevel); }
+
+    // Audio thread: writes the summed tones, scaled by the smoothed level, into out. Returns
+    // false, leaving out untouched, when the bank is silent and there is nothing to mix in.
+    bool render (float* out, int numSamples) noexcept
+    {
+        updateCoefficientsIfNeeded();
+
+        if (numLanes == 0 || (! level.isSmoothing() && level.getTargetValue() == 0.0f))
+            return false;
+
+        if (numLanes <= 4)
+            renderLanes<4> (out, numSamples);
+        else
+            renderLanes<maxTones> (out, numSamples);
+
+        level.applyGain (out, numSamples);
+        return true;
+    }
+
+private:
+    double sampleRate = 44100.0;
+    juce::SmoothedValue<float> level { 0.0f };
+
+    std::array<std::atomic<float>, maxTones> requestedHz;
+    std::atomic<int> version { 0 };
+    int appliedVersion = -1;
+
+    // Lane l runs tone laneTone[l] (-1: idle); the audible tones fill lanes [0, numLanes)
+    alignas (32) std::array<float, maxTones> re {}, im {}, cosInc {}, sinInc {}, gain {};
+    std::array<int, maxTones> laneTone {};
+    int numLanes = 0;
+
+    static bool isAudible (double hz, double rate) noexcept     { return hz > 0.0 && hz < rate * 0.5; }
+
+    template <int Lanes>
+    void renderLanes (float* out, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float sum = 0.0f;
+
+            for (int t = 0; t < Lanes; ++t)
+            {
+                const float r = re[(size_t) t] * cosInc[(size_t) t] - im[(size_t) t] * sinInc[(size_t) t];
+                const float m = re[(size_t) t] * sinInc[(size_t) t] + im[(size_t) t] * cosInc[(size_t) t];
+                re[(size_t) t] = r;
+                im[(size_t) t] = m;
+                sum += m * gain[(size_t) t];
+            }
+
+            out[i] = sum;
+        }
+
+        // One Newton step towards |z| = 1; cheap and branch-free
+        for (int t = 0; t < Lanes; ++t)
+        {
+            const float k = 1.5f - 0.5f * (re[(size_t) t] * re[(size_t) t] + im[(size_t) t] * im[(size_t) t]);
+            re[(size_t) t] *= k;
+            im[(size_t) t] *= k;
+        }
+    }
+
+    // Repacks the audible tones into the first lanes. A tone that stays on keeps its phasor, so
+    // switching another tone on or off doesn't click.
+    void updateCoefficientsIfNeeded() noexcept
+    {
+        const int v = version.load (std::memory_order_acquire);
+        if (v == appliedVersion)
+            return;
+
+        appliedVersion = v;
+
+        std::array<float, maxTones> toneRe, toneIm;
+        toneRe.fill (1.0f);
+        toneIm.fill (0.0f);
+
+        for (int l = 0; l < maxTones; ++l)
+        {
+            if (laneTone[(size_t) l] >= 0)
+            {
+                toneRe[(size_t) laneTone[(size_t) l]] = re[(size_t) l];
+                toneIm[(size_t) laneTone[(size_t) l]] = im[(size_t) l];
+            }
+        }
+
+        int numActive = 0;
+
+        for (int t = 0; t < maxTones; ++t)
+        {
+            const double hz = requestedHz[(size_t) t].load (std::memory_order_relaxed);
+
+            if (! isAudible (hz, sampleRate))
+                continue;
+
+            const double inc = juce::MathConstants<double>::twoPi * hz / sampleRate;
+            const auto l = (size_t) numActive++;
+
+            laneTone[l] = t;
+            re[l]       = toneRe[(size_t) t];
+            im[l]       = toneIm[(size_t) t];
+            cosInc[l]   = (float) std::cos (inc);
+            sinInc[l]   = (float) std::sin (inc);
+            gain[l]     = 1.0f;
+        }
+
+        numLanes = numActive;
+
+        // Idle lanes stay at rest with zero gain, so a 4- or 8-lane pass can include them
+        for (auto l = (size_t) numActive; l < (size_t) maxTones; ++l)
+        {
+            laneTone[l] = -1;
+            re[l] = 1.0f;
+            im[l] = 0.0f;
+            cosInc[l] = 1.0f;
+            sinInc[l] = 0.0f;
+            gain[l] = 0.0f;
+        }
+
+        // Keep the summed peak at the single-tone level
+        if (numActive > 1)
+            for (auto& g : gain)
+                g /= (float) numActive;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (TestToneBank)
+};
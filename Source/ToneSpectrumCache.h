@@ -0,0 +1,131 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+#include <vector>
+
+// Cache of windowed-sinusoid magnitude spectra for the reference tones.
+// The tones' frequencies are known exactly, so instead of running their signal through a
+// second FFT every hop, each (frequency, sample rate, FFT order, window) column is computed
+// once from the window's transform at unit amplitude and the caller rescales it by the level.
+// The image lobe at -f is added as well, so tones within lobeRadius bins of DC or Nyquist read
+// as the FFT would see them. Its phase against the main lobe follows the tone's phase at the
+// frame start, which the cache doesn't know, so the two are summed in power (the phase average).
+class ToneSpectrumCache
+{
+public:
+    using WindowType = juce::dsp::WindowingFunction<float>::WindowingMethod;
+
+    ToneSpectrumCache() = default;
+
+    // Not real-time safe on a miss (allocates and evaluates up to ~4 * lobeRadius window DTFT
+    // points).
+    // Returns 2^(fftOrder-1) magnitudes for a unit-amplitude tone, as the engine would report them.
+    const std::vector<float>& getColumn (float hz, double sampleRate, int fftOrder,
+                                         WindowType windowType = juce::dsp::WindowingFunction<float>::hann)
+    {
+        const Key key { hz, sampleRate, fftOrder, windowType };
+
+        for (auto& e : entries)
+            if (e.key == key)
+                return e.column;
+
+        if (entries.size() >= maxEntries)
+            entries.erase (entries.begin());
+
+        entries.push_back ({ key, buildColumn (key) });
+        return entries.back().column;
+    }
+
+private:
+    static constexpr size_t maxEntries = 32;
+    static constexpr int lobeRadius    = 48;    // Hann sidelobes are ~110 dB below the peak by here
+
+    struct Key
+    {
+        float hz;
+        double sampleRate;
+        int fftOrder;
+        WindowType windowType;
+
+        bool operator== (const Key& o) const noexcept
+        {
+            return hz == o.hz && sampleRate == o.sampleRate && fftOrder == o.fftOrder && windowType == o.windowType;
+        }
+    };
+
+    struct Entry
+    {
+        Key key;
+        std::vector<float> column;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<float> window;
+    int windowSize = 0;
+    WindowType windowTypeBuilt = juce::dsp::WindowingFunction<float>::hann;
+
+    std::vector<float> buildColumn (const Key& key)
+    {
+        const int n       = 1 << key.fftOrder;
+        const int numBins = n / 2;
+
+        if (windowSize != n || windowTypeBuilt != key.windowType)
+        {
+            window.resize ((size_t) n);
+            juce::dsp::WindowingFunction<float>::fillWindowingTables (window.data(), (size_t) n, key.windowType, true);
+            windowSize = n;
+            windowTypeBuilt = key.windowType;
+        }
+
+        std::vector<float> column ((size_t) numBins, 0.0f);
+
+        // X[k] = A/2j * (W(k - k0) e^{j phi} - W(k + k0) e^{-j phi}) for
+        // x[n] = A sin (2 pi k0 n / N + phi), W the window's DTFT (N-periodic, so the image near
+        // Nyquist is W(k + k0 - N))
+        const double centreBin = key.hz * n / key.sampleRate;
+        const int first = juce::jmax (0, (int) std::floor (centreBin) - lobeRadius);
+        const int last  = juce::jmin (numBins - 1, (int) std::ceil (centreBin) + lobeRadius);
+
+        for (int k = first; k <= last; ++k)
+            column[(size_t) k] = (float) (0.25 * getWindowPower (k - centreBin, n));
+
+        // Image lobe: bins with k + k0 within lobeRadius of 0 or N
+        const int imageLast  = juce::jmin (numBins - 1, (int) std::floor (lobeRadius - centreBin));
+        const int imageFirst = juce::jmax (0, (int) std::ceil (n - lobeRadius - centreBin));
+
+        for (int k = 0; k <= imageLast; ++k)
+            column[(size_t) k] += (float) (0.25 * getWindowPower (k + centreBin, n));
+
+        for (int k = juce::jmax (imageFirst, imageLast + 1); k < numBins; ++k)
+            column[(size_t) k] += (float) (0.25 * getWindowPower (k + centreBin - n, n));
+
+        for (auto& m : column)
+            m = std::sqrt (m);
+
+        return column;
+    }
+
+    // |W(offsetBins)|^2 for the built window
+    double getWindowPower (double offsetBins, int n) const
+    {
+        // e^{-j w i} by recursive rotation in double precision
+        const double w  = juce::MathConstants<double>::twoPi * offsetBins / n;
+        const double cr = std::cos (w), ci = -std::sin (w);
+        double pr = 1.0, pi = 0.0, re = 0.0, im = 0.0;
+
+        for (int i = 0; i < n; ++i)
+        {
+            re += window[(size_t) i] * pr;
+            im += window[(size_t) i] * pi;
+
+            const double nr = pr * cr - pi * ci;
+            pi = pr * ci + pi * cr;
+            pr = nr;
+        }
+
+        return re * re + im * im;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (ToneSpectrumCache)
+};
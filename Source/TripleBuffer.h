@@ -0,0 +1,64 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <array>
+
+// Wait-free single-writer / single-reader triple buffer.
+// The writer fills the back slot and publishes it by swapping it with the shared middle slot;
+// the reader swaps the middle slot into its front slot only when something new was published.
+// Neither side ever waits for the other, and the reader sees the newest complete frame in place.
+template <typename FrameType>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    // Not real-time safe: call before either thread starts using the buffer.
+    template <typename InitFn>
+    void initialise (InitFn&& init)
+    {
+        for (auto& s : slots)
+            init (s);
+
+        back = 0;
+        middle.store (1, std::memory_order_relaxed);
+        front = 2;
+    }
+
+    // ===== Writer =====
+    FrameType& getWriteFrame() noexcept     { return slots[(size_t) back]; }
+
+    void publish() noexcept
+    {
+        const auto prev = middle.exchange ((uint8_t) (back | freshBit), std::memory_order_acq_rel);
+        back = prev & indexMask;
+    }
+
+    // ===== Reader =====
+    // Returns the newest published frame; the reference stays valid until the next call.
+    const FrameType& read() noexcept
+    {
+        if ((middle.load (std::memory_order_relaxed) & freshBit) != 0)
+        {
+            const auto prev = middle.exchange (front, std::memory_order_acq_rel);
+            front = prev & indexMask;
+        }
+
+        return slots[(size_t) front];
+    }
+
+    bool hasNewFrame() const noexcept       { return (middle.load (std::memory_order_relaxed) & freshBit) != 0; }
+
+private:
+    static constexpr uint8_t indexMask = 0x3;
+    static constexpr uint8_t freshBit  = 0x4;
+
+    std::array<FrameType, 3> slots;
+
+    alignas (64) uint8_t back = 0;               // writer-owned
+    alignas (64) std::atomic<uint8_t> middle { 1 };
+    alignas (64) uint8_t front = 2;              // reader-owned
+
+    JUCE_DECLARE_NON_COPYABLE (TripleBuffer)
+};